@@ -0,0 +1,90 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#ifndef benchmark_hpp
+#define benchmark_hpp
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/*
+ A minimal timing harness. Each benchmark runs its operation in batches, doubling the batch until
+ one takes at least the minimum time, and reports the cost of a single operation from that batch.
+ */
+
+typedef struct {
+    std::string name;
+    uint64_t iterations;
+    double nanosecondsPerOp;
+    double bytesPerSecond;
+} TBenchmarkResult;
+
+/**
+ @brief    Stops the compiler from discarding a result that is otherwise unused.
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ @brief    Times an operation.
+ @param    name The name reported for the benchmark.
+ @param    bytesPerOp The number of bytes each operation processes, used for the throughput.
+ @param    minSeconds The minimum time the measured batch must take.
+ @param    op The operation, called once per iteration.
+ @return   The result of the benchmark.
+ */
+template <typename Op>
+TBenchmarkResult runBenchmark(const std::string& name, size_t bytesPerOp, double minSeconds, Op&& op) {
+    using Clock = std::chrono::steady_clock;
+    
+    op();
+    
+    uint64_t iterations = 1;
+    double seconds = 0.0;
+    for (;;) {
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            op();
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= minSeconds || iterations >= (1ULL << 40))
+            break;
+        iterations *= 2;
+    }
+    
+    return {name, iterations, seconds * 1e9 / (double)iterations, (double)bytesPerOp * (double)iterations / seconds};
+}
+
+/**
+ @brief    Prints a result as a single line, ns/op followed by MB/s.
+ */
+inline void printBenchmarkResult(const TBenchmarkResult& result) {
+    printf("%-48s %14.1f ns/op %12.1f MB/s\n", result.name.c_str(), result.nanosecondsPerOp, result.bytesPerSecond / 1e6);
+    fflush(stdout);
+}
+
+#endif /* benchmark_hpp */
@@ -0,0 +1,269 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+/*
+ Micro-benchmarks for the image primitives the tile matching depends on.
+ 
+ Usage: image_bench [--filter <text>] [--min-time <seconds>]
+ */
+
+#include "benchmark.hpp"
+#include "image.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+static const uint32_t tileSizes[] = {8, 16, 24, 32};
+static const int bitWidths[] = {8, 32};
+
+static std::string filter;
+static double minSeconds = 0.1;
+
+template <typename Op>
+static void benchmark(const std::string& name, size_t bytesPerOp, Op&& op) {
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+        return;
+    printBenchmarkResult(runBenchmark(name, bytesPerOp, minSeconds, op));
+}
+
+static std::string shapeName(uint32_t width, uint32_t height, int bitWidth) {
+    return std::to_string(width) + "x" + std::to_string(height) + " " + std::to_string(bitWidth) + "-bit";
+}
+
+/*
+ An image built from a small set of random tiles, so it compresses and matches like real tile art.
+ */
+static TImage* createTiledImage(uint32_t width, uint32_t height, int bitWidth, uint32_t tileSize, std::mt19937& random) {
+    TImage* image = createPixmap(width, height, bitWidth);
+    if (image == nullptr)
+        return nullptr;
+    
+    int bytesPerPixel = bitWidth / 8;
+    std::vector<uint8_t> tiles((size_t)tileSize * tileSize * bytesPerPixel * 16);
+    for (auto& byte : tiles) {
+        byte = (uint8_t)random();
+    }
+    
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x += tileSize) {
+            uint32_t tile = ((x / tileSize) * 7 + (y / tileSize) * 13) % 16;
+            size_t length = (size_t)std::min(tileSize, width - x) * bytesPerPixel;
+            memcpy(image->data + ((size_t)y * width + x) * bytesPerPixel,
+                   tiles.data() + (((size_t)tile * tileSize + y % tileSize) * tileSize) * bytesPerPixel, length);
+        }
+    }
+    return image;
+}
+
+/*
+ createPixmap only allocates whole bytes per pixel, so images of fewer bits per pixel are made here.
+ */
+static TImage* createPackedImage(uint32_t width, uint32_t height, int bitWidth, std::mt19937& random) {
+    TImage* image = (TImage *)malloc(sizeof(TImage));
+    if (image == nullptr)
+        return nullptr;
+    
+    size_t length = (size_t)width * height * bitWidth / 8;
+    image->width = width;
+    image->height = height;
+    image->bitWidth = bitWidth;
+    image->data = (uint8_t *)malloc(length);
+    if (image->data == nullptr) {
+        free(image);
+        return nullptr;
+    }
+    for (size_t i = 0; i < length; i++) {
+        image->data[i] = (uint8_t)random();
+    }
+    return image;
+}
+
+//MARK: - Pixmap Operations
+
+static void benchmarkPixmaps(std::mt19937& random) {
+    for (int bitWidth : bitWidths) {
+        TImage* source = createTiledImage(1024, 1024, bitWidth, 16, random);
+        for (uint32_t size : tileSizes) {
+            size_t bytes = (size_t)size * size * (bitWidth / 8);
+            TImage* tile = createPixmap(size, size, bitWidth);
+            copyPixmap(tile, 0, 0, source, 64, 64, size, size);
+            
+            benchmark("copyPixmap " + shapeName(size, size, bitWidth), bytes, [&]() {
+                copyPixmap(tile, 0, 0, source, 64, 64, size, size);
+                doNotOptimize(tile->data[0]);
+            });
+            
+            // An empty section is the worst case, every byte is read.
+            TImage* blank = createPixmap(size * 2, size * 2, bitWidth);
+            benchmark("containsImage " + shapeName(size, size, bitWidth), bytes, [&]() {
+                doNotOptimize(containsImage(blank, size / 2, size / 2, size, size));
+            });
+            reset(blank);
+            
+            benchmark("compareSubImage " + shapeName(size, size, bitWidth), bytes, [&]() {
+                doNotOptimize(compareSubImage(source, 64, 64, tile));
+            });
+            
+            benchmark("compareSubImageSimilarity " + shapeName(size, size, bitWidth), bytes, [&]() {
+                doNotOptimize(compareSubImageSimilarity(source, 64, 64, tile));
+            });
+            
+            reset(tile);
+        }
+        reset(source);
+    }
+}
+
+//MARK: - Tile Kernels
+
+/*
+ The cost of a single tile compare with the kernels xTiled selects for each tile shape, against the
+ generic kernels used for any other shape.
+ */
+static void benchmarkTileKernels(std::mt19937& random) {
+    const TTileKernels& generic = selectTileKernels(0, 0, 0);
+    
+    for (int bitWidth : bitWidths) {
+        TImage* source = createTiledImage(1024, 1024, bitWidth, 16, random);
+        for (uint32_t size : tileSizes) {
+            const TTileKernels& kernels = selectTileKernels(size, size, bitWidth);
+            size_t bytes = (size_t)size * size * (bitWidth / 8);
+            
+            // The tile is packed, as in the tileset, and the cell is a view into the image.
+            TImage* tile = createPixmap(size, size, bitWidth);
+            copyPixmap(tile, 0, 0, source, 64, 64, size, size);
+            TImageView a = makeImageView(tile, 0, 0, size, size);
+            TImageView b = makeImageView(source, 64, 64, size, size);
+            
+            for (const TTileKernels* k : {&kernels, &generic}) {
+                std::string suffix = std::string(" ") + shapeName(size, size, bitWidth) + " (" + k->name + ")";
+                benchmark("tile equal" + suffix, bytes, [&]() {
+                    doNotOptimize(k->equal(a, b));
+                });
+                benchmark("tile matchCount" + suffix, bytes, [&]() {
+                    doNotOptimize(k->matchCount(a, b));
+                });
+                benchmark("tile hash" + suffix, bytes, [&]() {
+                    doNotOptimize(k->hash(b));
+                });
+            }
+            reset(tile);
+        }
+        reset(source);
+    }
+}
+
+//MARK: - Conversions
+
+static void benchmarkConversions(std::mt19937& random) {
+    for (uint32_t size : {64u, 256u, 1024u}) {
+        TImage* image = createTiledImage(size, size, 32, 16, random);
+        for (int scale : {2, 4}) {
+            benchmark("scaleImage " + shapeName(size, size, 32) + " x" + std::to_string(scale), (size_t)size * size * 4 * scale * scale, [&]() {
+                TImage* scaled = scaleImage(image, scale);
+                doNotOptimize(scaled->data[0]);
+                reset(scaled);
+            });
+        }
+        reset(image);
+        
+        TImage* pixmap = createPackedImage(size, size, 4, random);
+        benchmark("convertPixmapTo8BitPixmap " + shapeName(size, size, 4), (size_t)size * size, [&]() {
+            TImage* converted = convertPixmapTo8BitPixmap(pixmap);
+            doNotOptimize(converted->data[0]);
+            reset(converted);
+        });
+        reset(pixmap);
+        
+        TImage* bitmap = createPackedImage(size, size, 1, random);
+        benchmark("convertMonochromeBitmapToPixmap " + shapeName(size, size, 1), (size_t)size * size, [&]() {
+            TImage* converted = convertMonochromeBitmapToPixmap(bitmap);
+            doNotOptimize(converted->data[0]);
+            reset(converted);
+        });
+        reset(bitmap);
+    }
+}
+
+//MARK: - PNG Files
+
+static void benchmarkPNGFiles(std::mt19937& random) {
+    std::string filename = std::filesystem::temp_directory_path() / ("image_bench_" + std::to_string(getpid()) + ".png");
+    
+    // saveImageAsPNGFile reports every file it saves, which would bury the results.
+    std::streambuf* output = std::cout.rdbuf(nullptr);
+    
+    for (uint32_t size : {256u, 1024u}) {
+        for (int bitWidth : bitWidths) {
+            TImage* image = createTiledImage(size, size, bitWidth, 16, random);
+            size_t bytes = (size_t)size * size * (bitWidth / 8);
+            
+            benchmark("saveImageAsPNGFile " + shapeName(size, size, bitWidth), bytes, [&]() {
+                doNotOptimize(saveImageAsPNGFile(image, filename));
+            });
+            
+            // 8-bit images are saved as grey and loaded back as RGBA, the bytes are those decoded.
+            benchmark("loadPNGGraphicFile " + shapeName(size, size, bitWidth), (size_t)size * size * 4, [&]() {
+                TImage* loaded = loadPNGGraphicFile(filename);
+                doNotOptimize(loaded->data[0]);
+                reset(loaded);
+            });
+            reset(image);
+        }
+    }
+    
+    std::cout.rdbuf(output);
+    std::cout.clear();
+    std::filesystem::remove(filename);
+}
+
+int main(int argc, const char * argv[]) {
+    for (int n = 1; n < argc; n++) {
+        std::string args(argv[n]);
+        if (args == "--filter" && n + 1 < argc) {
+            filter = argv[++n];
+            continue;
+        }
+        if (args == "--min-time" && n + 1 < argc) {
+            minSeconds = atof(argv[++n]);
+            continue;
+        }
+        std::cerr << "Usage: image_bench [--filter <text>] [--min-time <seconds>]" << std::endl;
+        return -1;
+    }
+    
+    std::cout << "Compare kernel: " << compareKernelName() << std::endl;
+    
+    std::mt19937 random(1);
+    benchmarkPixmaps(random);
+    benchmarkTileKernels(random);
+    benchmarkConversions(random);
+    benchmarkPNGFiles(random);
+    
+    return 0;
+}
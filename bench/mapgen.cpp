@@ -0,0 +1,99 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+/*
+ Writes a synthetic tile map image, so the same input can be converted with xtiled on any machine.
+ 
+ Usage: mapgen -o <output-file> [options], see help() for the options.
+ */
+
+#include "image.hpp"
+#include "mapgenerator.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static void help(void) {
+    std::cout
+    << "Usage: mapgen -o <output-file> [options]\n"
+    << "\n"
+    << "Options:\n"
+    << "  -o <output-file>        The PNG file to write.\n"
+    << "  --columns <columns>     Width of the map in tiles, defaults to 128.\n"
+    << "  --rows <rows>           Height of the map in tiles, defaults to 128.\n"
+    << "  -w <width>              Tile width in pixels, defaults to 16.\n"
+    << "  -h <height>             Tile height in pixels, defaults to 16.\n"
+    << "  --unique <count>        Number of distinct tiles, defaults to 512.\n"
+    << "  --zipf <exponent>       Tile i is used in proportion to 1 / (i + 1)^exponent, defaults\n"
+    << "                          to 0, every tile equally often.\n"
+    << "  --transparent <ratio>   Fraction of cells left fully transparent, defaults to 0.\n"
+    << "  --noise <ratio>         Fraction of the other cells that are near duplicates, defaults to 0.\n"
+    << "  --noise-pixels <count>  Pixels that differ in a near duplicate, defaults to 1.\n"
+    << "  --seed <seed>           Random seed, defaults to 1.\n";
+}
+
+int main(int argc, const char * argv[]) {
+    TMapGeneratorOptions options;
+    std::string out_filename;
+    
+    for (int n = 1; n < argc; n++) {
+        std::string args(argv[n]);
+        if (n + 1 == argc) {
+            help();
+            return -1;
+        }
+        std::string value(argv[++n]);
+        
+        if (args == "-o") out_filename = value;
+        else if (args == "--columns") options.columns = (uint32_t)atoi(value.c_str());
+        else if (args == "--rows") options.rows = (uint32_t)atoi(value.c_str());
+        else if (args == "-w") options.tileWidth = (uint32_t)atoi(value.c_str());
+        else if (args == "-h") options.tileHeight = (uint32_t)atoi(value.c_str());
+        else if (args == "--unique") options.uniqueTiles = (uint32_t)atoi(value.c_str());
+        else if (args == "--zipf") options.zipfExponent = (float)atof(value.c_str());
+        else if (args == "--transparent") options.transparentRatio = (float)atof(value.c_str());
+        else if (args == "--noise") options.noiseRatio = (float)atof(value.c_str());
+        else if (args == "--noise-pixels") options.noisePixels = (uint32_t)atoi(value.c_str());
+        else if (args == "--seed") options.seed = (uint32_t)atoi(value.c_str());
+        else {
+            help();
+            return -1;
+        }
+    }
+    
+    if (out_filename.empty()) {
+        help();
+        return -1;
+    }
+    
+    TImage* image = generateMapImage(options);
+    if (image == nullptr) {
+        std::cerr << "Error: Unable to generate the map, check the options." << std::endl;
+        return -1;
+    }
+    
+    bool success = saveImageAsPNGFile(image, out_filename);
+    reset(image);
+    return success ? 0 : -1;
+}
@@ -0,0 +1,102 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "mapgenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/*
+ Each tile is drawn from its own small palette, so tiles have the flat areas and repeated colours of
+ pixel art, which affects how well they compress and how similar they are to each other.
+ */
+static void generateTile(uint8_t* pixels, uint32_t pixelCount, std::mt19937& random) {
+    uint32_t palette[4];
+    for (auto& colour : palette) {
+        colour = (uint32_t)random() | 0xFF000000;
+    }
+    
+    uint32_t colour = palette[0];
+    for (uint32_t i = 0; i < pixelCount; i++) {
+        if (random() % 4 == 0) colour = palette[random() % 4];
+        memcpy(pixels + i * 4, &colour, 4);
+    }
+}
+
+TImage* generateMapImage(const TMapGeneratorOptions& options) {
+    if (!options.columns || !options.rows || !options.tileWidth || !options.tileHeight || !options.uniqueTiles)
+        return nullptr;
+    
+    TImage* image = createPixmap(options.columns * options.tileWidth, options.rows * options.tileHeight, 32);
+    if (image == nullptr)
+        return nullptr;
+    
+    std::mt19937 random(options.seed);
+    uint32_t pixelCount = options.tileWidth * options.tileHeight;
+    size_t bytesPerRow = (size_t)options.tileWidth * 4;
+    
+    std::vector<uint8_t> tiles((size_t)pixelCount * 4 * options.uniqueTiles);
+    for (uint32_t t = 0; t < options.uniqueTiles; t++) {
+        generateTile(tiles.data() + (size_t)pixelCount * 4 * t, pixelCount, random);
+    }
+    
+    // The cumulative weight of each tile, searched with a uniform value to pick a tile.
+    std::vector<double> weights(options.uniqueTiles);
+    double total = 0.0;
+    for (uint32_t t = 0; t < options.uniqueTiles; t++) {
+        total += 1.0 / std::pow((double)t + 1.0, (double)options.zipfExponent);
+        weights[t] = total;
+    }
+    
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<uint8_t> cell((size_t)pixelCount * 4);
+    for (uint32_t r = 0; r < options.rows; r++) {
+        for (uint32_t c = 0; c < options.columns; c++) {
+            // Transparent cells are left as they are, createPixmap clears every pixel.
+            if (uniform(random) < options.transparentRatio)
+                continue;
+            
+            size_t t = std::lower_bound(weights.begin(), weights.end(), uniform(random) * total) - weights.begin();
+            t = std::min<size_t>(t, options.uniqueTiles - 1);
+            memcpy(cell.data(), tiles.data() + (size_t)pixelCount * 4 * t, cell.size());
+            
+            if (uniform(random) < options.noiseRatio) {
+                for (uint32_t n = 0; n < options.noisePixels; n++) {
+                    uint32_t colour = (uint32_t)random() | 0xFF000000;
+                    memcpy(cell.data() + (size_t)(random() % pixelCount) * 4, &colour, 4);
+                }
+            }
+            
+            uint8_t* d = image->data + ((size_t)r * options.tileHeight * image->width + (size_t)c * options.tileWidth) * 4;
+            for (uint32_t y = 0; y < options.tileHeight; y++) {
+                memcpy(d, cell.data() + y * bytesPerRow, bytesPerRow);
+                d += (size_t)image->width * 4;
+            }
+        }
+    }
+    
+    return image;
+}
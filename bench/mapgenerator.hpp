@@ -0,0 +1,52 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#ifndef mapgenerator_hpp
+#define mapgenerator_hpp
+
+#include "image.hpp"
+
+/*
+ Options for a synthetic tile map image. The same options and seed always give the same image.
+ */
+typedef struct {
+    uint32_t columns = 128;         // Width of the map in tiles
+    uint32_t rows = 128;            // Height of the map in tiles
+    uint32_t tileWidth = 16;
+    uint32_t tileHeight = 16;
+    uint32_t uniqueTiles = 512;     // Number of distinct tiles the cells are drawn from
+    float zipfExponent = 0.0f;      // Tile i is used in proportion to 1 / (i + 1)^exponent, 0 is uniform
+    float transparentRatio = 0.0f;  // Fraction of cells left fully transparent
+    float noiseRatio = 0.0f;        // Fraction of the other cells that are near duplicates of their tile
+    uint32_t noisePixels = 1;       // Pixels that differ in a near duplicate
+    uint32_t seed = 1;
+} TMapGeneratorOptions;
+
+/**
+ @brief    Generates a 32-bit RGBA image of a tile map.
+ @param    options The options of the map.
+ @return   The image, or nullptr if the options are invalid or memory ran out.
+ */
+TImage* generateMapImage(const TMapGeneratorOptions& options);
+
+#endif /* mapgenerator_hpp */
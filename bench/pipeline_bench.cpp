@@ -0,0 +1,196 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+/*
+ End-to-end benchmark of the conversion pipeline on a corpus of synthetic maps. Each map is timed in
+ its three phases, loading the image, matching the tiles and saving the tileset and TMJ file, and the
+ results are written as JSON so runs from different commits can be compared.
+ 
+ Usage: pipeline_bench [--repeat <count>] [-j <threads>] [--filter <text>] [--corpus <directory>] [-o <json-file>]
+ */
+
+#include "image.hpp"
+#include "mapgenerator.hpp"
+#include "xtiled.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+typedef struct {
+    const char *name;
+    TMapGeneratorOptions map;
+    float similarityPercentage;
+    unsigned tileCount;
+} TCorpusEntry;
+
+static TMapGeneratorOptions mapOptions(uint32_t columns, uint32_t rows, uint32_t tileSize, uint32_t uniqueTiles,
+                                       float zipfExponent, float transparentRatio, float noiseRatio, uint32_t noisePixels) {
+    TMapGeneratorOptions options;
+    options.columns = columns;
+    options.rows = rows;
+    options.tileWidth = tileSize;
+    options.tileHeight = tileSize;
+    options.uniqueTiles = uniqueTiles;
+    options.zipfExponent = zipfExponent;
+    options.transparentRatio = transparentRatio;
+    options.noiseRatio = noiseRatio;
+    options.noisePixels = noisePixels;
+    return options;
+}
+
+static const TCorpusEntry corpus[] = {
+    {"uniform-16", mapOptions(128, 128, 16, 512, 0.0f, 0.0f, 0.0f, 0), 1.0f, 1024},
+    {"zipf-16", mapOptions(128, 128, 16, 2000, 1.1f, 0.2f, 0.0f, 0), 1.0f, 4096},
+    {"sparse-32", mapOptions(64, 64, 32, 256, 1.0f, 0.6f, 0.0f, 0), 1.0f, 1024},
+    {"noisy-8-similar", mapOptions(256, 256, 8, 256, 0.0f, 0.1f, 0.3f, 2), 0.95f, 1024},
+    {"generic-20", mapOptions(100, 100, 20, 500, 0.5f, 0.1f, 0.0f, 0), 1.0f, 1024}
+};
+
+static const char* phaseNames[] = {"loadTiledImage", "generateTMJData", "createTMJFile"};
+static constexpr int kPhaseCount = 3;
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+int main(int argc, const char * argv[]) {
+    int repeat = 3;
+    unsigned threads = 0;
+    std::string filter;
+    std::string directory;
+    std::string jsonFile;
+    
+    for (int n = 1; n < argc; n++) {
+        std::string args(argv[n]);
+        if (n + 1 < argc) {
+            if (args == "--repeat") { repeat = std::max(1, atoi(argv[++n])); continue; }
+            if (args == "-j") { threads = (unsigned)atoi(argv[++n]); continue; }
+            if (args == "--filter") { filter = argv[++n]; continue; }
+            if (args == "--corpus") { directory = argv[++n]; continue; }
+            if (args == "-o") { jsonFile = argv[++n]; continue; }
+        }
+        std::cerr << "Usage: pipeline_bench [--repeat <count>] [-j <threads>] [--filter <text>] [--corpus <directory>] [-o <json-file>]" << std::endl;
+        return -1;
+    }
+    
+    bool temporary = directory.empty();
+    if (temporary) {
+        directory = std::filesystem::temp_directory_path() / ("pipeline_bench_" + std::to_string(getpid()));
+    }
+    std::filesystem::create_directories(directory);
+    
+    FILE* json = jsonFile.empty() ? stdout : fopen(jsonFile.c_str(), "w");
+    if (json == nullptr) {
+        std::cerr << "Error: Unable to open file for writing: " << jsonFile << std::endl;
+        return -1;
+    }
+    
+    // xTiled reports every file it saves, which would be mixed in with the JSON.
+    std::streambuf* output = std::cout.rdbuf(nullptr);
+    
+    fprintf(json, "{\n  \"compareKernel\": \"%s\",\n  \"threads\": %u,\n  \"repeat\": %d,\n  \"results\": [", compareKernelName(), threads, repeat);
+    
+    bool first = true;
+    for (const TCorpusEntry& entry : corpus) {
+        if (!filter.empty() && std::string(entry.name).find(filter) == std::string::npos)
+            continue;
+        
+        // The corpus is generated again on every run, the generator is deterministic so the maps
+        // are always the same.
+        std::string imagefile = std::filesystem::path(directory) / (std::string(entry.name) + ".png");
+        TImage* image = generateMapImage(entry.map);
+        if (image == nullptr || !saveImageAsPNGFile(image, imagefile)) {
+            std::cerr << "Error: Unable to generate the map: " << entry.name << std::endl;
+            reset(image);
+            continue;
+        }
+        size_t imageBytes = (size_t)image->width * image->height * 4;
+        reset(image);
+        
+        std::vector<double> seconds[kPhaseCount];
+        std::string outputFile = std::filesystem::path(directory) / (std::string(entry.name) + "_out");
+        for (int r = 0; r < repeat; r++) {
+            xTiled xtiled;
+            xtiled.tileWidth = entry.map.tileWidth;
+            xtiled.tileHeight = entry.map.tileHeight;
+            xtiled.tileCount = entry.tileCount;
+            xtiled.similarityPercentage = entry.similarityPercentage;
+            xtiled.threads = threads;
+            
+            auto start = std::chrono::steady_clock::now();
+            auto lap = [&start](std::vector<double>& phase) {
+                auto now = std::chrono::steady_clock::now();
+                phase.push_back(std::chrono::duration<double>(now - start).count());
+                start = now;
+            };
+            
+            xtiled.loadTiledImage(imagefile);
+            lap(seconds[0]);
+            xtiled.generateTMJData();
+            lap(seconds[1]);
+            xtiled.createTMJFile(outputFile);
+            lap(seconds[2]);
+        }
+        
+        const TMapGeneratorOptions& map = entry.map;
+        fprintf(json, "%s\n    {\n      \"name\": \"%s\",\n", first ? "" : ",", entry.name);
+        fprintf(json, "      \"width\": %u,\n      \"height\": %u,\n      \"tileWidth\": %u,\n      \"tileHeight\": %u,\n",
+                map.columns * map.tileWidth, map.rows * map.tileHeight, map.tileWidth, map.tileHeight);
+        fprintf(json, "      \"uniqueTiles\": %u,\n      \"zipfExponent\": %g,\n      \"transparentRatio\": %g,\n      \"noiseRatio\": %g,\n      \"noisePixels\": %u,\n",
+                map.uniqueTiles, map.zipfExponent, map.transparentRatio, map.noiseRatio, map.noisePixels);
+        fprintf(json, "      \"similarity\": %g,\n      \"imageBytes\": %zu,\n      \"phases\": {", entry.similarityPercentage, imageBytes);
+        
+        double total = 0.0;
+        for (int p = 0; p < kPhaseCount; p++) {
+            double best = *std::min_element(seconds[p].begin(), seconds[p].end());
+            total += median(seconds[p]);
+            fprintf(json, "%s\n        \"%s\": {\"minSeconds\": %.6f, \"medianSeconds\": %.6f}", p ? "," : "", phaseNames[p], best, median(seconds[p]));
+        }
+        fprintf(json, "\n      },\n      \"totalMedianSeconds\": %.6f\n    }", total);
+        fflush(json);
+        first = false;
+        
+        std::cerr << entry.name << ": " << total << " s" << std::endl;
+    }
+    
+    fprintf(json, "\n  ]\n}\n");
+    if (json != stdout) fclose(json);
+    
+    std::cout.rdbuf(output);
+    std::cout.clear();
+    
+    if (temporary) {
+        std::filesystem::remove_all(directory);
+    }
+    
+    return 0;
+}
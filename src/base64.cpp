@@ -0,0 +1,194 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "base64.hpp"
+
+#include <array>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BASE64_X86_KERNELS
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BASE64_NEON_KERNELS
+#endif
+
+static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*
+ Encodes the whole groups of three bytes that the vector kernels leave over, and the final partial
+ group with its padding.
+ */
+static size_t base64EncodeScalar(const uint8_t* data, size_t length, char* out) {
+    char* p = out;
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3) {
+        uint32_t triple = (uint32_t)data[i] << 16 | (uint32_t)data[i + 1] << 8 | data[i + 2];
+        *p++ = kAlphabet[triple >> 18 & 63];
+        *p++ = kAlphabet[triple >> 12 & 63];
+        *p++ = kAlphabet[triple >> 6 & 63];
+        *p++ = kAlphabet[triple & 63];
+    }
+    
+    if (i < length) {
+        uint32_t triple = (uint32_t)data[i] << 16;
+        if (i + 1 < length) triple |= (uint32_t)data[i + 1] << 8;
+        *p++ = kAlphabet[triple >> 18 & 63];
+        *p++ = kAlphabet[triple >> 12 & 63];
+        *p++ = i + 1 < length ? kAlphabet[triple >> 6 & 63] : '=';
+        *p++ = '=';
+    }
+    
+    return p - out;
+}
+
+#ifdef BASE64_X86_KERNELS
+/*
+ Twelve bytes are spread over four 32-bit lanes, the four 6-bit indices of each lane are isolated with
+ two multiplies, then mapped to ASCII by adding an offset looked up from the range the index falls in.
+ */
+__attribute__((target("ssse3")))
+static size_t base64EncodeSSSE3(const uint8_t* data, size_t length, char* out) {
+    const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    char* p = out;
+    size_t i = 0;
+    
+    // Each step loads 16 bytes but only consumes 12 of them.
+    for (; i + 16 <= length; i += 12) {
+        __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + i)), shuffle);
+        
+        __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(t0, t1);
+        
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i lower = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(lower, _mm_set1_epi8(13)));
+        __m128i ascii = _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+        
+        _mm_storeu_si128((__m128i *)p, ascii);
+        p += 16;
+    }
+    
+    return (p - out) + base64EncodeScalar(data + i, length - i, p);
+}
+#endif
+
+#ifdef BASE64_NEON_KERNELS
+static size_t base64EncodeNEON(const uint8_t* data, size_t length, char* out) {
+    uint8x16x4_t alphabet;
+    alphabet.val[0] = vld1q_u8((const uint8_t *)kAlphabet);
+    alphabet.val[1] = vld1q_u8((const uint8_t *)kAlphabet + 16);
+    alphabet.val[2] = vld1q_u8((const uint8_t *)kAlphabet + 32);
+    alphabet.val[3] = vld1q_u8((const uint8_t *)kAlphabet + 48);
+    
+    char* p = out;
+    size_t i = 0;
+    for (; i + 48 <= length; i += 48) {
+        uint8x16x3_t in = vld3q_u8(data + i);
+        uint8x16x4_t indices;
+        indices.val[0] = vshrq_n_u8(in.val[0], 2);
+        indices.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), vdupq_n_u8(63));
+        indices.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), vdupq_n_u8(63));
+        indices.val[3] = vandq_u8(in.val[2], vdupq_n_u8(63));
+        
+        uint8x16x4_t ascii;
+        for (int n = 0; n < 4; n++) {
+            ascii.val[n] = vqtbl4q_u8(alphabet, indices.val[n]);
+        }
+        vst4q_u8((uint8_t *)p, ascii);
+        p += 64;
+    }
+    
+    return (p - out) + base64EncodeScalar(data + i, length - i, p);
+}
+#endif
+
+typedef size_t (*TBase64Encoder)(const uint8_t* data, size_t length, char* out);
+
+static TBase64Encoder selectBase64Encoder(void) {
+#ifdef BASE64_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3"))
+        return base64EncodeSSSE3;
+#endif
+#ifdef BASE64_NEON_KERNELS
+    return base64EncodeNEON;
+#endif
+    return base64EncodeScalar;
+}
+
+static const TBase64Encoder encoder = selectBase64Encoder();
+
+size_t base64Encode(const uint8_t* data, size_t length, char* out) {
+    return encoder(data, length, out);
+}
+
+std::string base64Encode(const uint8_t* data, size_t length) {
+    std::string text(base64EncodedLength(length), '\0');
+    text.resize(encoder(data, length, text.data()));
+    return text;
+}
+
+//MARK: - Decoding
+
+bool base64Decode(std::string_view text, std::vector<uint8_t>& data) {
+    // Maps each character to its 6-bit value, 0xFF for characters outside the alphabet.
+    static const auto kValues = [] {
+        std::array<uint8_t, 256> values;
+        values.fill(0xFF);
+        for (int i = 0; i < 64; i++) values[(uint8_t)kAlphabet[i]] = i;
+        return values;
+    }();
+    
+    while (!text.empty() && text.back() == '=') text.remove_suffix(1);
+    if (text.size() % 4 == 1)
+        return false;
+    
+    data.resize(text.size() * 3 / 4);
+    uint8_t* p = data.data();
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : text) {
+        uint8_t value = kValues[(uint8_t)c];
+        if (value == 0xFF)
+            return false;
+        bits = bits << 6 | value;
+        if (++count == 4) {
+            *p++ = bits >> 16;
+            *p++ = bits >> 8;
+            *p++ = bits;
+            bits = 0;
+            count = 0;
+        }
+    }
+    if (count == 3) {
+        *p++ = bits >> 10;
+        *p++ = bits >> 2;
+    } else if (count == 2) {
+        *p++ = bits >> 4;
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+
+#ifndef base64_hpp
+#define base64_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ @brief    Returns the number of characters needed to base64 encode the given number of bytes, including padding.
+ */
+inline size_t base64EncodedLength(size_t length) {
+    return (length + 2) / 3 * 4;
+}
+
+/**
+ @brief    Encodes data as base64 using the standard alphabet with '=' padding.
+           The fastest encoder supported by the CPU is selected at start-up.
+ @param    data The data to be encoded.
+ @param    length The number of bytes to be encoded.
+ @param    out The buffer for the encoded text, it must hold base64EncodedLength(length) characters.
+ @return   The number of characters written to out.
+ */
+size_t base64Encode(const uint8_t* data, size_t length, char* out);
+
+/**
+ @brief    Encodes data as base64 using the standard alphabet with '=' padding.
+ @param    data The data to be encoded.
+ @param    length The number of bytes to be encoded.
+ @return   The encoded text.
+ */
+std::string base64Encode(const uint8_t* data, size_t length);
+
+/**
+ @brief    Decodes base64 text in the standard alphabet, with or without '=' padding.
+ @param    text The text to be decoded.
+ @param    data The decoded bytes.
+ @return   false if the text is not valid base64.
+ */
+bool base64Decode(std::string_view text, std::vector<uint8_t>& data);
+
+#endif /* base64_hpp */
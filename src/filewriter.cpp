@@ -0,0 +1,78 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "filewriter.hpp"
+
+#include <charconv>
+#include <cstring>
+
+bool FileWriter::open(const std::string& filename) {
+    close();
+    _fp = std::fopen(filename.c_str(), "wb");
+    _length = 0;
+    _failed = _fp == nullptr;
+    return _fp != nullptr;
+}
+
+bool FileWriter::close(void) {
+    if (!_fp)
+        return !_failed;
+    
+    flush();
+    if (std::fclose(_fp) != 0) _failed = true;
+    _fp = nullptr;
+    return !_failed;
+}
+
+void FileWriter::flush(void) {
+    if (_fp && _length) {
+        if (std::fwrite(_buffer.data(), 1, _length, _fp) != _length) _failed = true;
+    }
+    _length = 0;
+}
+
+void FileWriter::write(const char* data, size_t length) {
+    if (_length + length > _buffer.size()) {
+        flush();
+        if (length > _buffer.size()) {
+            if (_fp && std::fwrite(data, 1, length, _fp) != length) _failed = true;
+            return;
+        }
+    }
+    memcpy(_buffer.data() + _length, data, length);
+    _length += length;
+}
+
+FileWriter& FileWriter::operator<<(int64_t value) {
+    if (_buffer.size() - _length < 20) flush();
+    auto result = std::to_chars(_buffer.data() + _length, _buffer.data() + _buffer.size(), value);
+    _length = result.ptr - _buffer.data();
+    return *this;
+}
+
+FileWriter& FileWriter::operator<<(uint64_t value) {
+    if (_buffer.size() - _length < 20) flush();
+    auto result = std::to_chars(_buffer.data() + _length, _buffer.data() + _buffer.size(), value);
+    _length = result.ptr - _buffer.data();
+    return *this;
+}
@@ -0,0 +1,89 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+
+#ifndef filewriter_hpp
+#define filewriter_hpp
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ A buffered writer for generating large text files in a single pass. Integers are formatted straight
+ into the buffer with std::to_chars, and the buffer is only handed to the file once it is full.
+ */
+class FileWriter {
+public:
+    explicit FileWriter(size_t capacity = 1 << 20) {
+        _buffer.resize(capacity);
+    }
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+    
+    ~FileWriter() {
+        close();
+    }
+    
+    bool open(const std::string& filename);
+    
+    /**
+     @brief    Flushes any buffered output and closes the file.
+     @return   true if everything written since open reached the file.
+     */
+    bool close(void);
+    
+    bool isOpen(void) const {
+        return _fp != nullptr;
+    }
+    
+    FileWriter& operator<<(std::string_view s) {
+        write(s.data(), s.size());
+        return *this;
+    }
+    
+    FileWriter& operator<<(char c) {
+        if (_length == _buffer.size()) flush();
+        _buffer[_length++] = c;
+        return *this;
+    }
+    
+    FileWriter& operator<<(int64_t value);
+    FileWriter& operator<<(uint64_t value);
+    FileWriter& operator<<(int value) { return *this << (int64_t)value; }
+    FileWriter& operator<<(unsigned value) { return *this << (uint64_t)value; }
+    
+    void write(const char* data, size_t length);
+    
+private:
+    void flush(void);
+    
+    std::FILE* _fp = nullptr;
+    std::vector<char> _buffer;
+    size_t _length = 0;
+    bool _failed = false;
+};
+
+#endif /* filewriter_hpp */
@@ -21,12 +21,22 @@
 // SOFTWARE.
 
 #include "image.hpp"
+#include "trace.hpp"
 
 #include <fstream>
 #include <cstring>
+#include <cmath>
 #include <vector>
 #include "png.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IMAGE_X86_KERNELS
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define IMAGE_NEON_KERNELS
+#endif
+
 
 /* Windows 3.x bitmap file header */
 typedef struct __attribute__((__packed__)) {
@@ -65,16 +75,43 @@ static bool isValidImage(const TImage* image) {
 static void flipImageVertically(const TImage *image)
 {
     uint8_t *byte = (uint8_t *)image->data;
-    int w = (int)image->width / (8 / image->bitWidth);
-    int h = (int)image->height;
+    size_t w = (size_t)image->width / (8 / image->bitWidth);
+    size_t h = image->height;
     
-    for (int row = 0; row < h / 2; ++row)
-        for (int col = 0; col < w; ++col)
+    for (size_t row = 0; row < h / 2; ++row)
+        for (size_t col = 0; col < w; ++col)
             std::swap(byte[col + row * w], byte[col + (h - 1 - row) * w]);
     
 }
 
+static void readPNGData(png_structp png, png_bytep data, png_size_t length) {
+    std::ifstream* file = static_cast<std::ifstream*>(png_get_io_ptr(png));
+    file->read(reinterpret_cast<char*>(data), length);
+}
+
+static void setPNGTransformsToRGBA(png_structp png, png_infop info) {
+    png_byte color_type = png_get_color_type(png, info);
+    png_byte bit_depth = png_get_bit_depth(png, info);
+
+    // Convert the PNG to 8-bit RGBA format
+    if (bit_depth == 16) png_set_strip_16(png);
+    if (color_type == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png);
+    if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) png_set_expand_gray_1_2_4_to_8(png);
+    if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA) png_set_gray_to_rgb(png);
+    
+    // Images without an alpha channel, palette images included, are given an opaque one.
+    if (png_get_valid(png, info, PNG_INFO_tRNS)) {
+        png_set_tRNS_to_alpha(png);
+    } else if (!(color_type & PNG_COLOR_MASK_ALPHA)) {
+        png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+    }
+
+    png_read_update_info(png, info);
+}
+
 TImage *loadPNGGraphicFile(const std::string& filename) {
+    Trace::Span span("loadPNGGraphicFile", filename);
+    
     TImage *image = (TImage *)malloc(sizeof(TImage ));
     if (!image) {
         return nullptr;
@@ -109,10 +146,7 @@ TImage *loadPNGGraphicFile(const std::string& filename) {
     }
 
     // Set the custom read function to use ifstream
-    png_set_read_fn(png, &file, [](png_structp png, png_bytep data, png_size_t length) {
-        std::ifstream* file = static_cast<std::ifstream*>(png_get_io_ptr(png));
-        file->read(reinterpret_cast<char*>(data), length);
-    });
+    png_set_read_fn(png, &file, readPNGData);
 
     // Inform libpng we've already read the first 8 bytes
     png_set_sig_bytes(png, 8);
@@ -120,32 +154,27 @@ TImage *loadPNGGraphicFile(const std::string& filename) {
     // Read the image info
     png_read_info(png, info);
 
-    int width = png_get_image_width(png, info);
-    int height = png_get_image_height(png, info);
-    png_byte color_type = png_get_color_type(png, info);
-    png_byte bit_depth = png_get_bit_depth(png, info);
-
-    // Convert the PNG to 8-bit RGBA format
-    if (bit_depth == 16) png_set_strip_16(png);
-    if (color_type == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png);
-    if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) png_set_expand_gray_1_2_4_to_8(png);
-    if (png_get_valid(png, info, PNG_INFO_tRNS)) png_set_tRNS_to_alpha(png);
-    if (color_type == PNG_COLOR_TYPE_RGB || color_type == PNG_COLOR_TYPE_GRAY) png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
-
-    png_read_update_info(png, info);
+    uint32_t width = png_get_image_width(png, info);
+    uint32_t height = png_get_image_height(png, info);
+    setPNGTransformsToRGBA(png, info);
 
     // Create the TImage structure
-    image->width = static_cast<uint16_t>(width);
-    image->height = static_cast<uint16_t>(height);
+    image->width = width;
+    image->height = height;
     image->bitWidth = 32;  // Assume we're loading in RGBA format (32 bits per pixel)
 
     // Allocate memory for the pixel data
-    size_t dataSize = width * height * 4; // 4 bytes per pixel (RGBA)
-    image->data = new uint8_t[dataSize];
+    size_t dataSize = (size_t)width * height * 4; // 4 bytes per pixel (RGBA)
+    image->data = (uint8_t *)malloc(dataSize);
+    if (!image->data) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        free(image);
+        throw std::runtime_error("Not enough memory to load: " + filename);
+    }
 
     // Read the image data row by row
     std::vector<png_bytep> row_pointers(height);
-    for (int y = 0; y < height; ++y) {
+    for (size_t y = 0; y < height; ++y) {
         row_pointers[y] = image->data + y * width * 4;
     }
 
@@ -157,6 +186,112 @@ TImage *loadPNGGraphicFile(const std::string& filename) {
     return image;
 }
 
+typedef struct {
+    std::ifstream file;
+    png_structp png;
+    png_infop info;
+} TPNGReaderContext;
+
+TPNGReader *openPNGGraphicFile(const std::string& filename) {
+    TPNGReaderContext* context = new TPNGReaderContext();
+    
+    context->file.open(filename, std::ios::binary);
+    if (!context->file.is_open()) {
+        delete context;
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    
+    png_byte header[8];
+    context->file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (context->file.gcount() != sizeof(header) || png_sig_cmp(header, 0, 8)) {
+        delete context;
+        throw std::runtime_error("File is not a valid PNG: " + filename);
+    }
+    
+    context->png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if (!context->png) {
+        delete context;
+        throw std::runtime_error("Failed to create PNG read struct");
+    }
+    
+    context->info = png_create_info_struct(context->png);
+    if (!context->info) {
+        png_destroy_read_struct(&context->png, nullptr, nullptr);
+        delete context;
+        throw std::runtime_error("Failed to create PNG info struct");
+    }
+    
+    if (setjmp(png_jmpbuf(context->png))) {
+        png_destroy_read_struct(&context->png, &context->info, nullptr);
+        delete context;
+        throw std::runtime_error("Error during PNG read");
+    }
+    
+    png_set_read_fn(context->png, &context->file, readPNGData);
+    png_set_sig_bytes(context->png, 8);
+    png_read_info(context->png, context->info);
+    
+    // Rows of an interlaced image are spread across several passes, so it can not be read a band at a time.
+    if (png_get_interlace_type(context->png, context->info) != PNG_INTERLACE_NONE) {
+        png_destroy_read_struct(&context->png, &context->info, nullptr);
+        delete context;
+        throw std::runtime_error("Interlaced PNG can not be streamed: " + filename);
+    }
+    
+    setPNGTransformsToRGBA(context->png, context->info);
+    
+    TPNGReader *reader = (TPNGReader *)malloc(sizeof(TPNGReader));
+    if (!reader) {
+        png_destroy_read_struct(&context->png, &context->info, nullptr);
+        delete context;
+        return nullptr;
+    }
+    
+    reader->width = png_get_image_width(context->png, context->info);
+    reader->height = png_get_image_height(context->png, context->info);
+    reader->bitWidth = 32;
+    reader->row = 0;
+    reader->context = context;
+    
+    return reader;
+}
+
+bool readPNGGraphicRows(TPNGReader* reader, uint8_t* data, uint32_t rowCount) {
+    if (!reader || !reader->context || !data)
+        return false;
+    
+    Trace::Span span("readPNGGraphicRows", reader->row, reader->row + rowCount);
+    
+    if (rowCount > reader->height - reader->row)
+        return false;
+    
+    TPNGReaderContext* context = (TPNGReaderContext *)reader->context;
+    if (setjmp(png_jmpbuf(context->png))) {
+        return false;
+    }
+    
+    size_t bytesPerRow = (size_t)reader->width * (reader->bitWidth / 8);
+    for (uint32_t y = 0; y < rowCount; y++) {
+        png_read_row(context->png, data + bytesPerRow * y, nullptr);
+    }
+    reader->row += rowCount;
+    
+    return true;
+}
+
+void closePNGGraphicFile(TPNGReader* &reader) {
+    if (!reader)
+        return;
+    
+    TPNGReaderContext* context = (TPNGReaderContext *)reader->context;
+    if (context) {
+        png_destroy_read_struct(&context->png, &context->info, nullptr);
+        delete context;
+    }
+    free(reader);
+    reader = nullptr;
+}
+
 TImage *loadBMPGraphicFile(const std::string& filename) {
     BIPHeader bip_header;
     
@@ -194,9 +329,9 @@ TImage *loadBMPGraphicFile(const std::string& filename) {
     size_t length = image->width / (8 / bip_header.biBitCount);
     
     infile.seekg(bip_header.fileHeader.bfOffBits, std::ios_base::beg);
-    for (int r = 0; r < image->height; ++r) {
+    for (uint32_t r = 0; r < image->height; ++r) {
         infile.read((char *)&image->data[length * r], length);
-        if (infile.gcount() != length) {
+        if ((size_t)infile.gcount() != length) {
             std::cout << filename << " Read failed!\n";
             break;
         }
@@ -250,7 +385,7 @@ TImage *loadPBMGraphicFile(const std::string &filename)
     getline(infile, s);
     image->height = atoi(s.c_str());
     
-    size_t length = ((image->width + 7) >> 3) * image->height;
+    size_t length = (((size_t)image->width + 7) >> 3) * image->height;
     image->data = (unsigned char *)malloc(length);
     
     if (!image->data) {
@@ -264,8 +399,12 @@ TImage *loadPBMGraphicFile(const std::string &filename)
     return image;
 }
 
-bool saveImageAsPNGFile(TImage* image, const std::string& filename) {
-
+/*
+ Saves an image as a PNG, an 8-bit image with a palette is saved as an indexed colour PNG.
+ */
+static bool savePNGFile(TImage* image, const std::vector<uint32_t>* palette, const std::string& filename) {
+    Trace::Span span("saveImageAsPNGFile", filename);
+    
     // Open file
     FILE* fp = fopen(filename.c_str(), "wb");
     if (!fp) {
@@ -305,7 +444,7 @@ bool saveImageAsPNGFile(TImage* image, const std::string& filename) {
     int color_type;
     switch (image->bitWidth) {
         case 8:
-            color_type = PNG_COLOR_TYPE_GRAY;
+            color_type = palette ? PNG_COLOR_TYPE_PALETTE : PNG_COLOR_TYPE_GRAY;
             break;
         case 24:
             color_type = PNG_COLOR_TYPE_RGB;
@@ -323,13 +462,28 @@ bool saveImageAsPNGFile(TImage* image, const std::string& filename) {
     png_set_IHDR(png, info, image->width, image->height, 8, color_type,
                  PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
 
+    if (palette) {
+        // The alpha of each colour goes in the tRNS chunk, which is left out when every colour is opaque.
+        std::vector<png_color> colors(palette->size());
+        std::vector<png_byte> alphas(palette->size());
+        bool opaque = true;
+        for (size_t i = 0; i < palette->size(); i++) {
+            uint32_t color = (*palette)[i];
+            colors[i] = {(png_byte)(color & 0xFF), (png_byte)(color >> 8 & 0xFF), (png_byte)(color >> 16 & 0xFF)};
+            alphas[i] = (png_byte)(color >> 24);
+            if (alphas[i] != 0xFF) opaque = false;
+        }
+        png_set_PLTE(png, info, colors.data(), (int)colors.size());
+        if (!opaque) png_set_tRNS(png, info, alphas.data(), (int)alphas.size(), nullptr);
+    }
+
     png_write_info(png, info);
 
     // Write image data row by row
     const int bytes_per_pixel = image->bitWidth / 8;
     std::vector<png_bytep> row_pointers(image->height);
     for (size_t y = 0; y < image->height; ++y) {
-        row_pointers[y] = (png_bytep)(&image->data[y * image->width * bytes_per_pixel]);
+        row_pointers[y] = (png_bytep)(&image->data[y * image->width * (size_t)bytes_per_pixel]);
     }
     png_write_image(png, row_pointers.data());
 
@@ -344,7 +498,59 @@ bool saveImageAsPNGFile(TImage* image, const std::string& filename) {
     return true;
 }
 
-TImage *createBitmap(int w, int h)
+bool saveImageAsPNGFile(TImage* image, const std::string& filename) {
+    return savePNGFile(image, nullptr, filename);
+}
+
+bool saveImageAsPNGFile(TImage* image, const std::vector<uint32_t>& palette, const std::string& filename) {
+    if (image->bitWidth != 8 || palette.empty() || palette.size() > 256) {
+        std::cerr << "Error: An indexed colour PNG needs an 8-bit image and a palette of 1 to 256 colours." << std::endl;
+        return false;
+    }
+    return savePNGFile(image, &palette, filename);
+}
+
+bool loadPNGPalette(const std::string& filename, std::vector<uint32_t>& palette) {
+    palette.clear();
+    
+    std::ifstream file(filename, std::ios::binary);
+    png_byte header[8];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file.is_open() || file.gcount() != sizeof(header) || png_sig_cmp(header, 0, 8))
+        return false;
+    
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if (!png)
+        return false;
+    png_infop info = png_create_info_struct(png);
+    if (!info || setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, info ? &info : nullptr, nullptr);
+        palette.clear();
+        return false;
+    }
+    
+    png_set_read_fn(png, &file, readPNGData);
+    png_set_sig_bytes(png, 8);
+    png_read_info(png, info);
+    
+    png_colorp colors;
+    int count = 0;
+    if (png_get_color_type(png, info) == PNG_COLOR_TYPE_PALETTE && png_get_PLTE(png, info, &colors, &count) == PNG_INFO_PLTE) {
+        png_bytep alphas = nullptr;
+        int alphaCount = 0;
+        png_get_tRNS(png, info, &alphas, &alphaCount, nullptr);
+        
+        for (int i = 0; i < count; i++) {
+            uint32_t alpha = i < alphaCount ? alphas[i] : 0xFF;
+            palette.push_back((uint32_t)colors[i].red | (uint32_t)colors[i].green << 8 | (uint32_t)colors[i].blue << 16 | alpha << 24);
+        }
+    }
+    
+    png_destroy_read_struct(&png, &info, nullptr);
+    return !palette.empty();
+}
+
+TImage *createBitmap(uint32_t w, uint32_t h)
 {
     TImage *image = (TImage *)malloc(sizeof(TImage ));
     if (!image) {
@@ -352,7 +558,7 @@ TImage *createBitmap(int w, int h)
     }
     
     w = (w + 7) & ~7;
-    image->data = (uint8_t *)calloc(sizeof(char), w * h / 8);
+    image->data = (uint8_t *)calloc(sizeof(char), (size_t)w * h / 8);
     if (!image->data) {
         free(image);
         return nullptr;
@@ -365,14 +571,14 @@ TImage *createBitmap(int w, int h)
     return image;
 }
 
-TImage *createPixmap(int w, int h, int bitWidth)
+TImage *createPixmap(uint32_t w, uint32_t h, int bitWidth)
 {
     TImage *image = (TImage *)malloc(sizeof(TImage ));
     if (!image) {
         return nullptr;
     }
     
-    image->data = (uint8_t *)calloc(sizeof(char), w * h * (bitWidth / 8));
+    image->data = (uint8_t *)calloc(sizeof(char), (size_t)w * h * (bitWidth / 8));
     if (!image->data) {
         free(image);
         return nullptr;
@@ -385,13 +591,13 @@ TImage *createPixmap(int w, int h, int bitWidth)
     return image;
 }
 
-static void blitCopy(const void* dst, int dx, int dy, int dstw, const void* src, int x, int y, int srcw, int w, int h, int bpp) {
+static void blitCopy(const void* dst, int dx, int dy, size_t dstw, const void* src, int x, int y, size_t srcw, uint32_t w, uint32_t h, int bpp) {
     uint8_t* d = (uint8_t *)dst;
     uint8_t* s = (uint8_t *)src;
-    d += dy * dstw + dx * bpp;
-    s += y * srcw + x * bpp;
+    d += dy * dstw + (size_t)dx * bpp;
+    s += y * srcw + (size_t)x * bpp;
     while (h--) {
-        memcpy(d, s, w * bpp);
+        memcpy(d, s, (size_t)w * bpp);
         d += dstw;
         s += srcw;
     }
@@ -415,7 +621,7 @@ static void blitCopy(const void* dst, int dx, int dy, int dstw, const void* src,
 //}
 
 
-void copyPixmap(const TImage *dst, int dx, int dy, const TImage *src, int x, int y, uint16_t w, uint16_t h) {
+void copyPixmap(const TImage *dst, int dx, int dy, const TImage *src, int x, int y, uint32_t w, uint32_t h) {
     if (!dst || !src)
         return;
     
@@ -423,11 +629,8 @@ void copyPixmap(const TImage *dst, int dx, int dy, const TImage *src, int x, int
         return;
     
     if (src->bitWidth != dst->bitWidth) return;
-    if (src->bitWidth == 32) {
-        blitCopy(dst->data, dx, dy, (int)dst->width * 4, src->data, x, y, (int)src->width * 4, w, h, 4);
-        return;
-    }
-    blitCopy(dst->data, dx, dy, (int)dst->width * 4, src->data, x, y, (int)src->width, w, h, 4);
+    int bytesPerPixel = src->bitWidth / 8;
+    blitCopy(dst->data, dx, dy, (size_t)dst->width * bytesPerPixel, src->data, x, y, (size_t)src->width * bytesPerPixel, w, h, bytesPerPixel);
 }
 
 TImage *convertMonochromeBitmapToPixmap(const TImage *monochrome) {
@@ -441,14 +644,14 @@ TImage *convertMonochromeBitmapToPixmap(const TImage *monochrome) {
     image->bitWidth = 8;
     image->width = monochrome->width;
     image->height = monochrome->height;
-    image->data = (uint8_t *)malloc(image->width * image->height);
+    image->data = (uint8_t *)malloc((size_t)image->width * image->height);
     if (!image->data) return image;
     
-    memset(image->data, 0, image->width * image->height);
+    memset(image->data, 0, (size_t)image->width * image->height);
     
     uint8_t *dest = (uint8_t *)image->data;
     
-    int x, y;
+    uint32_t x, y;
     for (y=0; y<monochrome->height; y++) {
         bitPosition = 1 << 7;
         for (x=0; x<monochrome->width; x++) {
@@ -480,14 +683,15 @@ TImage *convertPixmapTo8BitPixmap(const TImage *pixmap)
     image->bitWidth = 8;
     image->width = pixmap->width;
     image->height = pixmap->height;
-    image->data = (uint8_t *)malloc(image->width * image->height);
+    image->data = (uint8_t *)malloc((size_t)image->width * image->height);
     if (!image->data) return image;
     
-    memset(image->data, 0, image->width * image->height);
+    memset(image->data, 0, (size_t)image->width * image->height);
     
     uint8_t *dest = (uint8_t *)image->data;
     
-    int length = pixmap->width * pixmap->height;
+    // The length of the packed source in bytes.
+    size_t length = (size_t)pixmap->width * pixmap->height * pixmap->bitWidth / 8;
     
     while (length--) {
         uint8_t byte = *src++;
@@ -511,7 +715,7 @@ void convertPixmapTo8BitPixmapNoCopy(TImage *pixmap)
     if (pixmap->bitWidth != 4 && pixmap->bitWidth != 2)
         return;
     
-    uint8_t* new_data = (uint8_t *)malloc(pixmap->width * pixmap->height);
+    uint8_t* new_data = (uint8_t *)malloc((size_t)pixmap->width * pixmap->height);
     if (new_data == nullptr)
         return;
     
@@ -519,7 +723,8 @@ void convertPixmapTo8BitPixmapNoCopy(TImage *pixmap)
     
     uint8_t *src = (uint8_t *)pixmap->data;
     
-    int length = pixmap->width * pixmap->height;
+    // The length of the packed source in bytes.
+    size_t length = (size_t)pixmap->width * pixmap->height * pixmap->bitWidth / 8;
     
     while (length--) {
         uint8_t byte = *src++;
@@ -549,19 +754,19 @@ void reset(TImage *&image)
     }
 }
 
-bool containsImage(const TImage *image, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+bool containsImage(const TImage *image, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
 {
     if (!image || !image->data) return false;
-    if (x + w > image->width || y + h > image->height) return false;
+    if ((uint64_t)x + w > image->width || (uint64_t)y + h > image->height) return false;
     uint8_t *p = (uint8_t *)image->data;
     
     int bytesPerPixel = image->bitWidth / 8;
-    int bytesToSkip = (image->width - w) * bytesPerPixel;
-    int lengthInBytes = w * bytesPerPixel;
+    size_t bytesToSkip = (size_t)(image->width - w) * bytesPerPixel;
+    size_t lengthInBytes = (size_t)w * bytesPerPixel;
     
-    p += (x * bytesPerPixel) + (image->width * bytesPerPixel) * y;
+    p += ((size_t)x * bytesPerPixel) + ((size_t)image->width * bytesPerPixel) * y;
     while (h--) {
-        for (int i = 0; i < lengthInBytes; i++) {
+        for (size_t i = 0; i < lengthInBytes; i++) {
             if (*p++)
                 return true;
         }
@@ -592,9 +797,9 @@ TImage *extractImageSectionMasked(TImage *image, uint8_t maskColor)
     minX = image->width - 1;
     minY = image->height - 1;
     
-    for (int y=0; y<image->height; y++) {
-        for (int x=0; x<image->width; x++) {
-            if (p[x + y * image->width] == maskColor) continue;
+    for (int y=0; y<(int)image->height; y++) {
+        for (int x=0; x<(int)image->width; x++) {
+            if (p[x + (size_t)y * image->width] == maskColor) continue;
             if (minX > x) minX = x;
             if (maxX < x) maxX = x;
             if (minY > y) minY = y;
@@ -635,8 +840,8 @@ TImage* scaleImage(const TImage *image, int scale) {
     
                      
     // Iterate through the bitmap and draw it scaled
-    for (int y = 0; y < image->height; y++) {
-        for (int x = 0; x < image->width; x++) {
+    for (size_t y = 0; y < image->height; y++) {
+        for (size_t x = 0; x < image->width; x++) {
             // Access pixel color data from the bitmap array
             uint32_t color = src[y * image->width + x];
             
@@ -644,8 +849,8 @@ TImage* scaleImage(const TImage *image, int scale) {
             for (float sy = 0; sy < scale_y; sy += 1.0f) {
                 for (float sx = 0; sx < scale_x; sx += 1.0f) {
                     // Calculate the scaled position
-                    int posX = (int)(x * scale_x + sx);
-                    int posY = (int)(y * scale_y + sy);
+                    size_t posX = (size_t)(x * scale_x + sx);
+                    size_t posY = (size_t)(y * scale_y + sy);
                     dest[posX + posY * scaledImage->width] = color;
                 }
             }
@@ -654,6 +859,260 @@ TImage* scaleImage(const TImage *image, int scale) {
     return scaledImage;
 }
 
+// MARK: - Compare Kernels
+
+/*
+ The byte compare kernels used by the image view compare functions. Each kernel works on a single
+ row of bytes, the best kernel supported by the CPU is selected once at start-up.
+ */
+
+typedef struct {
+    const char *name;
+    size_t (*countEqualBytes)(const uint8_t* a, const uint8_t* b, size_t length);
+    bool (*equalBytes)(const uint8_t* a, const uint8_t* b, size_t length);
+} TCompareKernels;
+
+static size_t countEqualBytesScalar(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t matchCount = 0;
+    for (size_t i = 0; i < length; i++) {
+        matchCount += a[i] == b[i];
+    }
+    return matchCount;
+}
+
+static bool equalBytesScalar(const uint8_t* a, const uint8_t* b, size_t length) {
+    return memcmp(a, b, length) == 0;
+}
+
+#ifdef IMAGE_X86_KERNELS
+__attribute__((target("sse4.1,popcnt")))
+static size_t countEqualBytesSSE41(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t matchCount = 0;
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        matchCount += _mm_popcnt_u32(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+    }
+    return matchCount + countEqualBytesScalar(a + i, b + i, length - i);
+}
+
+__attribute__((target("sse4.1")))
+static bool equalBytesSSE41(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF)
+            return false;
+    }
+    return equalBytesScalar(a + i, b + i, length - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t countEqualBytesAVX2(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t matchCount = 0;
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        matchCount += _mm_popcnt_u32((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+    }
+    return matchCount + countEqualBytesSSE41(a + i, b + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static bool equalBytesAVX2(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        if ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != 0xFFFFFFFF)
+            return false;
+    }
+    return equalBytesSSE41(a + i, b + i, length - i);
+}
+#endif
+
+#ifdef IMAGE_NEON_KERNELS
+static size_t countEqualBytesNEON(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t matchCount = 0;
+    size_t i = 0;
+    const uint8x16_t one = vdupq_n_u8(1);
+    for (; i + 32 <= length; i += 32) {
+        uint8x16_t eq0 = vandq_u8(vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i)), one);
+        uint8x16_t eq1 = vandq_u8(vceqq_u8(vld1q_u8(a + i + 16), vld1q_u8(b + i + 16)), one);
+        matchCount += vaddvq_u8(vaddq_u8(eq0, eq1));
+    }
+    return matchCount + countEqualBytesScalar(a + i, b + i, length - i);
+}
+
+static bool equalBytesNEON(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        uint8x16_t eq0 = vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        uint8x16_t eq1 = vceqq_u8(vld1q_u8(a + i + 16), vld1q_u8(b + i + 16));
+        if (vminvq_u8(vandq_u8(eq0, eq1)) != 0xFF)
+            return false;
+    }
+    return equalBytesScalar(a + i, b + i, length - i);
+}
+#endif
+
+static TCompareKernels selectCompareKernels(void) {
+#ifdef IMAGE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        return {"avx2", countEqualBytesAVX2, equalBytesAVX2};
+    if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt"))
+        return {"sse4.1", countEqualBytesSSE41, equalBytesSSE41};
+#endif
+#ifdef IMAGE_NEON_KERNELS
+    return {"neon", countEqualBytesNEON, equalBytesNEON};
+#endif
+    return {"scalar", countEqualBytesScalar, equalBytesScalar};
+}
+
+static const TCompareKernels compareKernels = selectCompareKernels();
+
+const char *compareKernelName(void) {
+    return compareKernels.name;
+}
+
+TImageView makeImageView(const TImage* image, int x, int y, int w, int h) {
+    TImageView view = {nullptr, 0, 0, 0, 0};
+    if (!isValidImage(image))
+        return view;
+    
+    int bytesPerPixel = image->bitWidth / 8;
+    view.stride = (size_t)image->width * bytesPerPixel;
+    view.data = image->data + (size_t)x * bytesPerPixel + view.stride * y;
+    view.width = w;
+    view.height = h;
+    view.bitWidth = image->bitWidth;
+    return view;
+}
+
+static bool isValidImageView(const TImageView& view) {
+    if (view.data == nullptr)
+        return false;
+    if (!view.width || !view.height) return false;
+    if (view.bitWidth < 8) return false;
+    return true;
+}
+
+static bool isSameShape(const TImageView& a, const TImageView& b) {
+    return a.width == b.width && a.height == b.height && a.bitWidth == b.bitWidth;
+}
+
+bool compareImageViews(const TImageView& a, const TImageView& b) {
+    if (!isValidImageView(a) || !isValidImageView(b))
+        return false;
+    
+    if (!isSameShape(a, b))
+        return false;
+    
+    size_t lengthInBytes = (size_t)a.width * (a.bitWidth / 8);
+    const uint8_t* dataA = a.data;
+    const uint8_t* dataB = b.data;
+    
+    for (uint32_t height = a.height; height; height--) {
+        if (!compareKernels.equalBytes(dataA, dataB, lengthInBytes))
+            return false;
+        dataA += a.stride;
+        dataB += b.stride;
+    }
+    
+    return true;
+}
+
+size_t compareImageViewMatchCount(const TImageView& a, const TImageView& b) {
+    if (!isValidImageView(a) || !isValidImageView(b))
+        return 0;
+    
+    if (!isSameShape(a, b))
+        return 0;
+    
+    size_t lengthInBytes = (size_t)a.width * (a.bitWidth / 8);
+    const uint8_t* dataA = a.data;
+    const uint8_t* dataB = b.data;
+    size_t matchCount = 0;
+    
+    for (uint32_t height = a.height; height; height--) {
+        matchCount += compareKernels.countEqualBytes(dataA, dataB, lengthInBytes);
+        dataA += a.stride;
+        dataB += b.stride;
+    }
+    
+    return matchCount;
+}
+
+float compareImageViewSimilarity(const TImageView& a, const TImageView& b) {
+    if (!isValidImageView(a) || !isValidImageView(b))
+        return false;
+    
+    if (!isSameShape(a, b))
+        return false;
+    
+    size_t lengthInBytes = (size_t)a.width * (a.bitWidth / 8) * a.height;
+    return (float)compareImageViewMatchCount(a, b) / (float)lengthInBytes;
+}
+
+/*
+ The smallest number of matching bytes out of lengthInBytes for which the similarity, computed in the
+ same way as compareImageViewSimilarity, reaches the threshold.
+ */
+static size_t requiredMatchCount(size_t lengthInBytes, float threshold) {
+    if (threshold <= 0.0f)
+        return 0;
+    
+    double estimate = std::ceil((double)threshold * (double)lengthInBytes);
+    size_t required = estimate > (double)lengthInBytes ? lengthInBytes + 1 : (size_t)estimate;
+    
+    // Correct for rounding in the float division used by compareImageViewSimilarity.
+    while (required > 0 && (float)(required - 1) / (float)lengthInBytes >= threshold)
+        required--;
+    while (required <= lengthInBytes && (float)required / (float)lengthInBytes < threshold)
+        required++;
+    
+    return required;
+}
+
+bool compareImageViewAtLeast(const TImageView& a, const TImageView& b, float threshold) {
+    if (!isValidImageView(a) || !isValidImageView(b))
+        return false;
+    
+    if (!isSameShape(a, b))
+        return false;
+    
+    size_t lengthInBytes = (size_t)a.width * (a.bitWidth / 8);
+    size_t required = requiredMatchCount(lengthInBytes * a.height, threshold);
+    
+    if (required > lengthInBytes * a.height)
+        return false;
+    
+    if (required == lengthInBytes * a.height)
+        return compareImageViews(a, b);
+    
+    const uint8_t* dataA = a.data;
+    const uint8_t* dataB = b.data;
+    size_t matchCount = 0;
+    size_t remaining = lengthInBytes * a.height;
+    
+    for (uint32_t height = a.height; height; height--) {
+        if (matchCount >= required)
+            return true;
+        if (matchCount + remaining < required)
+            return false;
+        matchCount += compareKernels.countEqualBytes(dataA, dataB, lengthInBytes);
+        remaining -= lengthInBytes;
+        dataA += a.stride;
+        dataB += b.stride;
+    }
+    
+    return matchCount >= required;
+}
+
 bool compareSubImage(const TImage* imageA, int x, int y, const TImage* imageB) {
     if (!isValidImage(imageA))
         return false;
@@ -667,29 +1126,28 @@ bool compareSubImage(const TImage* imageA, int x, int y, const TImage* imageB) {
     if (imageB->height > imageA->height)
         return false;
     
-    int bytesPerPixel = imageA->bitWidth / 8;
-    int bytesToSkip = (imageA->width - imageB->width) * bytesPerPixel;
-    int height = imageB->height;
+    return compareImageViews(makeImageView(imageA, x, y, imageB->width, imageB->height),
+                             makeImageView(imageB, 0, 0, imageB->width, imageB->height));
+}
+
+float compareSubImageSimilarity(const TImage* imageA, int x, int y, const TImage* imageB) {
+    if (!isValidImage(imageA))
+        return false;
     
-    uint8_t* dataA = imageA->data;
-    uint8_t* dataB = imageB->data;
+    if (!isValidImage(imageB))
+        return false;
     
-    dataA += x * bytesPerPixel + imageA->width * bytesPerPixel * y;
+    if (imageB->width > imageA->width)
+        return false;
     
-    while (height--) {
-        for (int i = 0; i < imageB->width * bytesPerPixel; i++) {
-            if (*dataA != *dataB)
-                return false;
-            dataA++;
-            dataB++;
-        }
-        dataA += bytesToSkip;
-    }
+    if (imageB->height > imageA->height)
+        return false;
     
-    return true;
+    return compareImageViewSimilarity(makeImageView(imageA, x, y, imageB->width, imageB->height),
+                                      makeImageView(imageB, 0, 0, imageB->width, imageB->height));
 }
 
-float compareSubImageSimilarity(const TImage* imageA, int x, int y, const TImage* imageB) {
+bool compareSubImageAtLeast(const TImage* imageA, int x, int y, const TImage* imageB, float threshold) {
     if (!isValidImage(imageA))
         return false;
     
@@ -702,33 +1160,316 @@ float compareSubImageSimilarity(const TImage* imageA, int x, int y, const TImage
     if (imageB->height > imageA->height)
         return false;
     
-    int bytesPerPixel = imageA->bitWidth / 8;
-    int bytesToSkip = (imageA->width - imageB->width) * bytesPerPixel;
-    int height = imageB->height;
+    return compareImageViewAtLeast(makeImageView(imageA, x, y, imageB->width, imageB->height),
+                                   makeImageView(imageB, 0, 0, imageB->width, imageB->height), threshold);
+}
+
+bool isImageViewUniform(const TImageView& view, uint32_t& pixel) {
+    if (!isValidImageView(view) || view.bitWidth / 8 > sizeof(pixel))
+        return false;
+    
+    size_t bytesPerPixel = view.bitWidth / 8;
+    size_t lengthInBytes = (size_t)view.width * bytesPerPixel;
+    
+    // A row whose bytes equal the bytes one pixel further on repeats its first pixel throughout, after
+    // that every row only has to equal the first, so both checks run on the compare kernels.
+    if (!compareKernels.equalBytes(view.data, view.data + bytesPerPixel, lengthInBytes - bytesPerPixel))
+        return false;
     
-    uint8_t* dataA = imageA->data;
-    uint8_t* dataB = imageB->data;
+    const uint8_t* row = view.data + view.stride;
+    for (uint32_t height = view.height - 1; height; height--) {
+        if (!compareKernels.equalBytes(view.data, row, lengthInBytes))
+            return false;
+        row += view.stride;
+    }
     
-    dataA += x * bytesPerPixel + imageA->width * bytesPerPixel * y;
-    int matchCount = 0;
+    pixel = 0;
+    memcpy(&pixel, view.data, bytesPerPixel);
+    return true;
+}
+
+bool isImageViewTransparent(const TImageView& view) {
+    if (!isValidImageView(view) || view.bitWidth != 32)
+        return false;
     
-    while (height--) {
-        for (int i = 0; i < imageB->width * bytesPerPixel; i++) {
-            if (*dataA == *dataB)
-                matchCount++;
-            dataA++;
-            dataB++;
+    // The alpha of every pixel is ORed together, which the compiler turns into vector instructions.
+    uint32_t alpha = 0;
+    const uint8_t* row = view.data;
+    for (uint32_t height = view.height; height; height--) {
+        for (uint32_t x = 0; x < view.width; x++) {
+            alpha |= row[x * 4 + 3];
         }
-        dataA += bytesToSkip;
+        if (alpha)
+            return false;
+        row += view.stride;
     }
     
-    float similarityPercentage;
-    int lengthInBytes = imageB->width * imageB->height * bytesPerPixel;
-    similarityPercentage = (float)matchCount / (float)lengthInBytes;
+    return true;
+}
+
+void copyImageView(const TImage* dst, int dx, int dy, const TImageView& src) {
+    if (!dst || !dst->data || !isValidImageView(src))
+        return;
+    
+    if (src.bitWidth != dst->bitWidth) return;
+    
+    int bytesPerPixel = dst->bitWidth / 8;
+    size_t lengthInBytes = (size_t)src.width * bytesPerPixel;
+    size_t bytesPerRow = (size_t)dst->width * bytesPerPixel;
     
-    return similarityPercentage;
+    uint8_t* d = dst->data + (size_t)dx * bytesPerPixel + bytesPerRow * dy;
+    const uint8_t* s = src.data;
+    for (uint32_t height = src.height; height; height--) {
+        memcpy(d, s, lengthInBytes);
+        d += bytesPerRow;
+        s += src.stride;
+    }
 }
 
+static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
 
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
 
+static inline uint64_t hashRound(uint64_t acc, uint64_t lane) {
+    acc ^= rotl64(lane * kPrime2, 31) * kPrime1;
+    return rotl64(acc, 27) * kPrime1 + kPrime3;
+}
 
+TImageView flipImageView(const TImageView& view, bool flipH, bool flipV, bool flipD, uint8_t* data) {
+    int bytesPerPixel = view.bitWidth / 8;
+    uint32_t width = flipD ? view.height : view.width;
+    uint32_t height = flipD ? view.width : view.height;
+    
+    // Displayed pixel (x, y) comes from (u, v) once mirrored, and u and v swap places for a diagonal flip.
+    uint8_t* d = data;
+    for (uint32_t y = 0; y < height; y++) {
+        uint32_t v = flipV ? height - 1 - y : y;
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t u = flipH ? width - 1 - x : x;
+            const uint8_t* s = flipD ? view.data + view.stride * u + (size_t)v * bytesPerPixel : view.data + view.stride * v + (size_t)u * bytesPerPixel;
+            memcpy(d, s, bytesPerPixel);
+            d += bytesPerPixel;
+        }
+    }
+    
+    return {data, (size_t)width * bytesPerPixel, width, height, view.bitWidth};
+}
+
+/*
+ Hashes rows of pixels, inlined into the tile kernels so that the lengths become constants there. The
+ result only depends on the pixels, so every kernel gives the same hash as hashImageView.
+ */
+__attribute__((always_inline))
+static inline uint64_t hashRows(const uint8_t* row, size_t stride, size_t lengthInBytes, uint32_t rowCount) {
+    uint64_t acc = kPrime3 ^ (lengthInBytes * rowCount * kPrime1);
+    
+    for (uint32_t height = rowCount; height; height--) {
+        const uint8_t* p = row;
+        size_t length = lengthInBytes;
+        while (length >= 8) {
+            uint64_t lane;
+            memcpy(&lane, p, 8);
+            acc = hashRound(acc, lane);
+            p += 8;
+            length -= 8;
+        }
+        while (length--) {
+            acc = hashRound(acc, *p++);
+        }
+        row += stride;
+    }
+    
+    // Final avalanche so that every input bit affects every output bit.
+    acc ^= acc >> 33;
+    acc *= kPrime2;
+    acc ^= acc >> 29;
+    acc *= kPrime3;
+    acc ^= acc >> 32;
+    
+    return acc;
+}
+
+uint64_t hashImageView(const TImageView& view) {
+    if (!isValidImageView(view))
+        return 0;
+    
+    return hashRows(view.data, view.stride, (size_t)view.width * (view.bitWidth / 8), view.height);
+}
+
+uint64_t hashSubImage(const TImage* image, int x, int y, int w, int h) {
+    return hashImageView(makeImageView(image, x, y, w, h));
+}
+
+
+// MARK: - Tile Kernels
+
+/*
+ Kernels for a single tile shape, with the row length and row count as template parameters so every
+ loop has a fixed trip count and fixed-size loads. The byte compares use 16-byte vectors, which are
+ SSE2 on x86-64 and NEON on arm64, so no run-time CPU check is needed.
+ */
+
+typedef uint8_t TByteVector __attribute__((vector_size(16)));
+
+static inline TByteVector loadByteVector(const uint8_t* p) {
+    TByteVector v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t loadLane(const uint8_t* p) {
+    uint64_t lane;
+    memcpy(&lane, p, sizeof(lane));
+    return lane;
+}
+
+/*
+ Sets the low bit of every byte of the lane that is zero and clears every other bit.
+ */
+static inline uint64_t zeroByteMask(uint64_t x) {
+    constexpr uint64_t kLow7 = 0x7F7F7F7F7F7F7F7FULL;
+    return ~(((x & kLow7) + kLow7) | x) >> 7 & 0x0101010101010101ULL;
+}
+
+template <size_t Length>
+static inline size_t countEqualRow(const uint8_t* a, const uint8_t* b) {
+    // Each equal byte subtracts -1 from its counter, at most Length / 16 per counter.
+    TByteVector counts = {};
+    size_t i = 0;
+    for (; i + 16 <= Length; i += 16) {
+        counts -= (TByteVector)(loadByteVector(a + i) == loadByteVector(b + i));
+    }
+    
+    uint64_t lanes[2];
+    memcpy(lanes, &counts, sizeof(lanes));
+    uint64_t sums = lanes[0] + lanes[1];
+    for (; i + 8 <= Length; i += 8) {
+        sums += zeroByteMask(loadLane(a + i) ^ loadLane(b + i));
+    }
+    return (size_t)(sums * 0x0101010101010101ULL >> 56);
+}
+
+template <size_t Length>
+static inline bool equalRow(const uint8_t* a, const uint8_t* b) {
+    TByteVector diff = {};
+    size_t i = 0;
+    for (; i + 16 <= Length; i += 16) {
+        diff |= loadByteVector(a + i) ^ loadByteVector(b + i);
+    }
+    
+    uint64_t lanes[2];
+    memcpy(lanes, &diff, sizeof(lanes));
+    uint64_t bits = lanes[0] | lanes[1];
+    for (; i + 8 <= Length; i += 8) {
+        bits |= loadLane(a + i) ^ loadLane(b + i);
+    }
+    return bits == 0;
+}
+
+template <size_t Length, uint32_t Height>
+static bool equalTile(const TImageView& a, const TImageView& b) {
+    const uint8_t* dataA = a.data;
+    const uint8_t* dataB = b.data;
+    for (uint32_t y = 0; y < Height; y++) {
+        if (!equalRow<Length>(dataA, dataB))
+            return false;
+        dataA += a.stride;
+        dataB += b.stride;
+    }
+    return true;
+}
+
+template <size_t Length, uint32_t Height>
+static size_t matchCountTile(const TImageView& a, const TImageView& b) {
+    const uint8_t* dataA = a.data;
+    const uint8_t* dataB = b.data;
+    size_t matchCount = 0;
+    for (uint32_t y = 0; y < Height; y++) {
+        matchCount += countEqualRow<Length>(dataA, dataB);
+        dataA += a.stride;
+        dataB += b.stride;
+    }
+    return matchCount;
+}
+
+template <size_t Length, uint32_t Height>
+static bool atLeastTile(const TImageView& a, const TImageView& b, float threshold) {
+    size_t required = requiredMatchCount(Length * Height, threshold);
+    if (required > Length * Height)
+        return false;
+    
+    const uint8_t* dataA = a.data;
+    const uint8_t* dataB = b.data;
+    size_t matchCount = 0;
+    for (uint32_t y = 0; y < Height; y++) {
+        if (matchCount >= required)
+            return true;
+        if (matchCount + (Height - y) * Length < required)
+            return false;
+        matchCount += countEqualRow<Length>(dataA, dataB);
+        dataA += a.stride;
+        dataB += b.stride;
+    }
+    return matchCount >= required;
+}
+
+template <size_t Length, uint32_t Height>
+static uint64_t hashTile(const TImageView& view) {
+    return hashRows(view.data, view.stride, Length, Height);
+}
+
+template <size_t Length, uint32_t Height>
+static void copyTile(uint8_t* dst, size_t stride, const TImageView& src) {
+    const uint8_t* s = src.data;
+    for (uint32_t y = 0; y < Height; y++) {
+        memcpy(dst, s, Length);
+        dst += stride;
+        s += src.stride;
+    }
+}
+
+template <uint32_t Width, uint32_t Height, uint8_t BitWidth>
+static constexpr TTileKernels makeTileKernels(const char* name) {
+    constexpr size_t length = (size_t)Width * (BitWidth / 8);
+    return {name, Width, Height, BitWidth,
+        equalTile<length, Height>, matchCountTile<length, Height>, atLeastTile<length, Height>,
+        hashTile<length, Height>, copyTile<length, Height>};
+}
+
+static void copyTileGeneric(uint8_t* dst, size_t stride, const TImageView& src) {
+    size_t lengthInBytes = (size_t)src.width * (src.bitWidth / 8);
+    const uint8_t* s = src.data;
+    for (uint32_t height = src.height; height; height--) {
+        memcpy(dst, s, lengthInBytes);
+        dst += stride;
+        s += src.stride;
+    }
+}
+
+static const TTileKernels genericTileKernels = {
+    "generic", 0, 0, 0,
+    compareImageViews, compareImageViewMatchCount, compareImageViewAtLeast, hashImageView, copyTileGeneric
+};
+
+static const TTileKernels tileKernelTable[] = {
+    makeTileKernels<8, 8, 32>("8x8 rgba"),
+    makeTileKernels<16, 16, 32>("16x16 rgba"),
+    makeTileKernels<24, 24, 32>("24x24 rgba"),
+    makeTileKernels<32, 32, 32>("32x32 rgba"),
+    makeTileKernels<8, 8, 8>("8x8 indexed"),
+    makeTileKernels<16, 16, 8>("16x16 indexed"),
+    makeTileKernels<24, 24, 8>("24x24 indexed"),
+    makeTileKernels<32, 32, 8>("32x32 indexed")
+};
+
+const TTileKernels& selectTileKernels(uint32_t width, uint32_t height, uint8_t bitWidth) {
+    for (const TTileKernels& kernels : tileKernelTable) {
+        if (kernels.width == width && kernels.height == height && kernels.bitWidth == bitWidth)
+            return kernels;
+    }
+    return genericTileKernels;
+}
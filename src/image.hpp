@@ -26,16 +26,35 @@
 #include <iostream>
 #include <sstream>
 #include <stdint.h>
+#include <vector>
 
 #define copyImageAt(dst, x, y, src) copyPixmap(dst, x, y, src, 0, 0, src->width, src->height)
 
 typedef struct __attribute__((__packed__)) {
-    uint16_t width;
-    uint16_t height;
+    uint32_t width;
+    uint32_t height;
     uint8_t  bitWidth;
     uint8_t *data;
 } TImage;
 
+/// A Portable Network Graphic (PNG) file opened for reading a band of rows at a time.
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint8_t  bitWidth;
+    uint32_t row;           // Next row to be read
+    void    *context;
+} TPNGReader;
+
+/// A non-owning, strided window onto the pixels of an image, used to work on tiles in place.
+typedef struct {
+    const uint8_t *data;    // Address of the top-left pixel
+    size_t   stride;        // Number of bytes from the start of one row to the start of the next
+    uint32_t width;
+    uint32_t height;
+    uint8_t  bitWidth;
+} TImageView;
+
 /**
  @brief    Loads a file in the Portable Network Graphic (PNG) format.
  @param    filename The filename of the Portable Network Graphic (PNG) to be loaded.
@@ -43,6 +62,29 @@ typedef struct __attribute__((__packed__)) {
  */
 TImage *loadPNGGraphicFile(const std::string& filename);
 
+/**
+ @brief    Opens a file in the Portable Network Graphic (PNG) format for reading its rows in order, a band at a time,
+           so that the whole image never has to be held in memory. Rows are always read in RGBA format.
+ @param    filename The filename of the Portable Network Graphic (PNG) to be read.
+ @return   The reader, which must be closed with closePNGGraphicFile.
+ */
+TPNGReader *openPNGGraphicFile(const std::string& filename);
+
+/**
+ @brief    Reads the next rows of a Portable Network Graphic (PNG).
+ @param    reader The reader returned by openPNGGraphicFile.
+ @param    data The buffer the rows are read into, it must hold rowCount rows of reader->width pixels.
+ @param    rowCount The number of rows to read.
+ @return   true on success, false on a read error or if fewer than rowCount rows remain.
+ */
+bool readPNGGraphicRows(TPNGReader* reader, uint8_t* data, uint32_t rowCount);
+
+/**
+ @brief    Closes a Portable Network Graphic (PNG) reader and frees the memory allocated for it.
+ @param    reader The reader to be closed.
+ */
+void closePNGGraphicFile(TPNGReader* &reader);
+
 /**
  @brief    Loads a file in the Bitmap (BMP) format.
  @param    filename The filename of the Bitmap (BMP) to be loaded.
@@ -65,13 +107,30 @@ TImage *loadPBMGraphicFile(const std::string& filename);
  */
 bool saveImageAsPNGFile(TImage* image, const std::string& filename);
 
+/**
+ @brief    Saves an 8-bit image in the Portable Network Graphic (PNG) format as indexed colour.
+ @param    image The image, each pixel being an index into the palette.
+ @param    palette The colours, as RGBA bytes in memory order, one to 256 of them.
+ @param    filename The filename of the Portable Network Graphic (PNG) to be saved.
+ @return   A true on success.
+ */
+bool saveImageAsPNGFile(TImage* image, const std::vector<uint32_t>& palette, const std::string& filename);
+
+/**
+ @brief    Reads the palette of an indexed colour Portable Network Graphic (PNG) file.
+ @param    filename The filename of the Portable Network Graphic (PNG).
+ @param    palette The colours of the palette, as RGBA bytes in memory order.
+ @return   true if the file is an indexed colour PNG with a palette.
+ */
+bool loadPNGPalette(const std::string& filename, std::vector<uint32_t>& palette);
+
 /**
  @brief    Creates a bitmap with the specified dimensions.
  @param    w The width of the bitmap.
  @param    h The height of the bitmap.
  @return   A structure containing the bitmap image data.
  */
-TImage *createBitmap(int w, int h);
+TImage *createBitmap(uint32_t w, uint32_t h);
 
 /**
  @brief    Creates a pixmap with the specified dimensions.
@@ -80,7 +139,7 @@ TImage *createBitmap(int w, int h);
  @param    bitWidth The bit width of the bitmap.
  @return   A structure containing the pixmap image data.
  */
-TImage *createPixmap(int w, int h, int bitWidth);
+TImage *createPixmap(uint32_t w, uint32_t h, int bitWidth);
 
 /**
  @brief    Copies a section of a pixmap to another bitmap.
@@ -93,7 +152,7 @@ TImage *createPixmap(int w, int h, int bitWidth);
  @param    w The width of the pixmap to be copied.
  @param    h The height of the pixmap to be copied.
  */
-void copyPixmap(const TImage* dst, int dx, int dy, const TImage* src, int x, int y, uint16_t w, uint16_t h);
+void copyPixmap(const TImage* dst, int dx, int dy, const TImage* src, int x, int y, uint32_t w, uint32_t h);
 
 /**
  @brief    Converts a monochrome bitmap to a pixmap, where each pixel is represented by a single byte.
@@ -129,7 +188,7 @@ void reset(TImage* &image);
  @param    w The width of the pixmap section to inspect.
  @param    h The height of the pixmap section to inspect.
  */
-bool containsImage(const TImage* image, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+bool containsImage(const TImage* image, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
 
 /**
  @brief    Takes an input image and identifies and extracts a section of the image that contains an actual image.
@@ -153,7 +212,7 @@ TImage *extractImageSectionMasked(TImage* image, uint8_t maskColor);
  @param    w The width of the pixmap section to grab.
  @param    h The height of the pixmap section to grab.
  */
-TImage *grabImageSectionMasked(TImage* image, uint8_t maskColor, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+TImage *grabImageSectionMasked(TImage* image, uint8_t maskColor, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
 
 TImage* scaleImage(const TImage *image, int scale);
 
@@ -178,3 +237,147 @@ bool compareSubImage(const TImage* imageA, int x, int y, const TImage* imageB);
            where 0% indicates no similarity and 100% indicates perfect similarity.
  */
 float compareSubImageSimilarity(const TImage* imageA, int x, int y, const TImage* imageB);
+
+/**
+ @brief    Computes a 64-bit hash of the pixel content of a subsection of an image.
+           Identical subsections always produce identical hashes, so the hash can be used to index tiles
+           for exact matching, a hit must still be verified with compareSubImage.
+ @param    image The image containing the subsection to be hashed.
+ @param    x The x-coordinate of the top-left corner of the subsection.
+ @param    y The y-coordinate of the top-left corner of the subsection.
+ @param    w The width of the subsection.
+ @param    h The height of the subsection.
+ @return   The 64-bit hash of the subsection.
+ */
+uint64_t hashSubImage(const TImage* image, int x, int y, int w, int h);
+
+/**
+ @brief    Compares a specified subsection of imageA with imageB and returns true if their similarity reaches the threshold.
+           Unlike compareSubImageSimilarity, the comparison stops as soon as the outcome is known, when the threshold is 1.0
+           it stops at the first mismatch.
+ @param    imageA Pointer to the first image (imageA) containing the subsection to be compared.
+ @param    x The x-coordinate of the top-left corner of the subsection in imageA from which the comparison begins.
+ @param    y The y-coordinate of the top-left corner of the subsection in imageA from which the comparison begins.
+ @param    imageB Pointer to the second image (imageB) to be compared against the specified subsection of imageA.
+ @param    threshold The minimum similarity, from 0.0 to 1.0, required for a match.
+ @return   true if compareSubImageSimilarity would return a value greater than or equal to threshold, otherwise false.
+ */
+bool compareSubImageAtLeast(const TImage* imageA, int x, int y, const TImage* imageB, float threshold);
+
+/**
+ @brief    Creates a view onto a subsection of an image without copying any pixel data.
+ @param    image The image that the view will refer to, it must outlive the view.
+ @param    x The x-coordinate of the top-left corner of the subsection.
+ @param    y The y-coordinate of the top-left corner of the subsection.
+ @param    w The width of the subsection.
+ @param    h The height of the subsection.
+ @return   A view of the subsection, or an empty view if the image is invalid.
+ */
+TImageView makeImageView(const TImage* image, int x, int y, int w, int h);
+
+/**
+ @brief    Returns the name of the byte compare kernel selected for this CPU, one of "avx2", "sse4.1", "neon" or "scalar".
+ */
+const char *compareKernelName(void);
+
+/**
+ @brief    Compares two image views and returns true if they are identical, otherwise false.
+ @param    a The first image view.
+ @param    b The second image view, it must have the same dimensions and bit width as the first.
+ @return   true if both views contain exactly the same pixels, otherwise false.
+ */
+bool compareImageViews(const TImageView& a, const TImageView& b);
+
+/**
+ @brief    Counts the number of bytes that are equal in two image views.
+ @param    a The first image view.
+ @param    b The second image view, it must have the same dimensions and bit width as the first.
+ @return   The number of equal bytes, the byte distance between the views is their size in bytes less this count.
+ */
+size_t compareImageViewMatchCount(const TImageView& a, const TImageView& b);
+
+/**
+ @brief    Compares two image views and returns a similarity value from 0.0 (completely different) to 1.0 (identical).
+ @param    a The first image view.
+ @param    b The second image view, it must have the same dimensions and bit width as the first.
+ @return   The fraction of bytes that are equal in both views.
+ */
+float compareImageViewSimilarity(const TImageView& a, const TImageView& b);
+
+/**
+ @brief    Compares two image views and returns true if their similarity reaches the threshold, stopping as soon as the outcome is known.
+ @param    a The first image view.
+ @param    b The second image view, it must have the same dimensions and bit width as the first.
+ @param    threshold The minimum similarity, from 0.0 to 1.0, required for a match.
+ @return   true if compareImageViewSimilarity would return a value greater than or equal to threshold, otherwise false.
+ */
+bool compareImageViewAtLeast(const TImageView& a, const TImageView& b, float threshold);
+
+/**
+ @brief    Checks whether every pixel of an image view has the same value.
+ @param    view The image view to be checked.
+ @param    pixel Set to the value of the pixels, in memory order, when they are all the same.
+ @return   true if every pixel has the same value.
+ */
+bool isImageViewUniform(const TImageView& view, uint32_t& pixel);
+
+/**
+ @brief    Checks whether every pixel of a 32-bit RGBA image view is fully transparent.
+ @param    view The image view to be checked.
+ @return   true if the alpha of every pixel is 0, always false for other bit widths.
+ */
+bool isImageViewTransparent(const TImageView& view);
+
+/**
+ @brief    Copies the pixels of an image view into a pixmap.
+ @param    dst The pixmap to which the view will be copied.
+ @param    dx The horizontal position within the destination pixmap.
+ @param    dy The vertical position within the destination pixmap.
+ @param    src The image view to be copied.
+ */
+void copyImageView(const TImage* dst, int dx, int dy, const TImageView& src);
+
+/**
+ @brief    Copies the pixels of an image view into a tightly packed buffer, flipped the way Tiled flips a
+           tile. The diagonal flip, which swaps x and y, is applied before the other two.
+ @param    view The image view to be copied.
+ @param    flipH Mirror the pixels horizontally.
+ @param    flipV Mirror the pixels vertically.
+ @param    flipD Swap the x and y axes.
+ @param    data The buffer, it must hold view.width x view.height pixels.
+ @return   A view of the flipped pixels in the buffer.
+ */
+TImageView flipImageView(const TImageView& view, bool flipH, bool flipV, bool flipD, uint8_t* data);
+
+/**
+ @brief    Computes a 64-bit hash of the pixel content of an image view.
+ @param    view The image view to be hashed.
+ @return   The 64-bit hash of the view, the stride does not affect the result.
+ */
+uint64_t hashImageView(const TImageView& view);
+
+/*
+ The compare, hash and copy functions for tiles of one shape. The kernels for the common tile sizes are
+ compiled for that size, any other shape gets kernels that call the image view functions above. Both
+ views given to a kernel must have the shape it was selected for, which is not checked.
+ */
+typedef struct {
+    const char *name;
+    uint32_t width;
+    uint32_t height;
+    uint8_t bitWidth;
+    bool (*equal)(const TImageView& a, const TImageView& b);                        // As compareImageViews
+    size_t (*matchCount)(const TImageView& a, const TImageView& b);                 // As compareImageViewMatchCount
+    bool (*atLeast)(const TImageView& a, const TImageView& b, float threshold);    // As compareImageViewAtLeast
+    uint64_t (*hash)(const TImageView& view);                                       // As hashImageView
+    void (*copy)(uint8_t* dst, size_t stride, const TImageView& src);               // Copies the tile to rows stride bytes apart
+} TTileKernels;
+
+/**
+ @brief    Returns the tile kernels for a tile shape.
+ @param    width The width of the tiles in pixels.
+ @param    height The height of the tiles in pixels.
+ @param    bitWidth The bit width of the tiles.
+ @return   The kernels compiled for that shape, or the generic kernels when there are none.
+ */
+const TTileKernels& selectTileKernels(uint32_t width, uint32_t height, uint8_t bitWidth);
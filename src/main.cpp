@@ -25,8 +25,13 @@
 #include <string>
 #include <fstream>
 #include <array>
+#include <filesystem>
+#include <map>
+#include <vector>
 
 #include "xtiled.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 
 
 #include "../version_code.h"
@@ -95,6 +100,19 @@ namespace std::filesystem {
     }
 }
 
+/*
+ Finishes the trace and reports the stats when main returns, so a conversion that fails still shows
+ where its time went.
+ */
+struct ExitReport {
+    bool json = false;
+    
+    ~ExitReport() {
+        Trace::finish();
+        ConversionStats::report(std::cerr, json);
+    }
+};
+
 // MARK: - Command Line
 void version(void) {
     using namespace std;
@@ -138,7 +156,8 @@ void help(void) {
     << "Copyright (C) 2024-" << YEAR << " Insoft.\n"
     << "Insoft "<< NAME << " version, " << VERSION_NUMBER << " (BUILD " << VERSION_CODE << ")\n"
     << "\n"
-    << "Usage: " << COMMAND_NAME << " <input-file> [-o <output-file>] [-w <width>] [-h <height>] [-t <tilecount>] [-s <similarity>]\n"
+    << "Usage: " << COMMAND_NAME << " <input-file> [-o <output-file>] [-w <width>] [-h <height>] [-t <tilecount>] [-s <similarity>] [-j <threads>] [--flip] [--indexed] [--stream] [--stats[=json]] [--trace <trace-file>] [--layer-encoding <encoding>] [--chunk-size <size>] [--index <index-file>] [--update <previous-file>]\n"
+    << "       [--tileset <tileset-file> [--margin <margin>] [--spacing <spacing>] [--no-append]]\n"
     << "\n"
     << "Options:\n"
     << "  -o <output-file>        Specify the filename for generated tmj code.\n"
@@ -146,8 +165,40 @@ void help(void) {
     << "  -h  <height>            Specify the height of the tiles used.\n"
     << "  -c  <tilecount>         Specify the number of tiles used.\n"
     << "  -s  <similarity>        Specify similarity percentage of tiles for matching.\n"
+    << "  -j  <threads>           Specify the number of threads used, defaults to all cores.\n"
+    << "  --flip                  Match tiles that are flipped or rotated copies of a tile, storing\n"
+    << "                          the copies as flipped GIDs.\n"
+    << "  --indexed               Work on palette indices rather than RGBA, for images of up to\n"
+    << "                          256 colours, and save the tileset as an indexed colour PNG.\n"
+    << "  --stream                Decode the image a row of tiles at a time to reduce memory use.\n"
+    << "  --stats[=<format>]      Report the time taken by each phase, counters and peak memory\n"
+    << "                          use on stderr, as text (default) or json.\n"
+    << "  --trace <trace-file>    Record the conversion in Chrome trace event format, for\n"
+    << "                          chrome://tracing or Perfetto.\n"
+    << "  --layer-encoding <encoding>\n"
+    << "                          Specify how tile layer data is stored: csv (default), base64,\n"
+    << "                          zlib, gzip or zstd.\n"
+    << "  --chunk-size <size>     Write an infinite map in chunks of size x size tiles, chunks\n"
+    << "                          without any tiles are left out.\n"
+    << "  --index <index-file>    Reuse the tileset recorded in the index file, if it exists, so\n"
+    << "                          existing tiles keep their GIDs, and update the index file.\n"
+    << "  --update <previous-file>\n"
+    << "                          Update the existing output map, previously converted from the\n"
+    << "                          previous file, only matching the tiles that have changed.\n"
+    << "  --tileset <tileset-file>\n"
+    << "                          Match tiles against an existing tileset, which keeps its layout\n"
+    << "                          and GIDs. Tiles not in it are added to a copy of it.\n"
+    << "  --margin <margin>       Specify the margin around the tiles of the tileset, in pixels.\n"
+    << "  --spacing <spacing>     Specify the spacing between the tiles of the tileset, in pixels.\n"
+    << "  --no-append             Leave cells whose tile is not in the tileset empty, the tmj file\n"
+    << "                          refers to the tileset itself.\n"
     << "\n"
     << "Additional Commands:\n"
+    << "  " << COMMAND_NAME << " batch <input-file>... [-o <directory>] [options]\n"
+    << "                          Build one tileset shared by all of the input files, saved as\n"
+    << "                          tileset.png in the directory along with a tmj file per input.\n"
+    << "                          The input files must have different names, --stream and\n"
+    << "                          --update can not be used.\n"
     << "  " << COMMAND_NAME << " {--version | --help }\n"
     << "    --version              Display the version information.\n"
     << "    --help                 Show this help message.\n";
@@ -161,45 +212,159 @@ int main(int argc, const char * argv[])
     }
     
     std::string out_filename, in_filename;
+    std::string previous_filename;
+    std::vector<std::string> in_filenames;
+    std::string stats_format;
+    std::string trace_filename;
     
-    
+    // xtiled batch <input-file>... -o <directory>
+    bool batch = std::string(argv[1]) == "batch";
     
     xTiled xtiled = xTiled();
     
-    for( int n = 1; n < argc; n++ ) {
+    for( int n = batch ? 2 : 1; n < argc; n++ ) {
         if (*argv[n] == '-') {
             std::string args(argv[n]);
             
             if (args == "-o") {
-                if (++n > argc) error();
+                if (++n >= argc) error();
                 out_filename = argv[n];
                 continue;
             }
             
             if (args == "-w") {
-                if (++n > argc) error();
+                if (++n >= argc) error();
                 xtiled.tileWidth = atoi(argv[n]);
                 continue;
             }
             
             if (args == "-h") {
-                if (++n > argc) error();
+                if (++n >= argc) error();
                 xtiled.tileHeight = atoi(argv[n]);
                 continue;
             }
             
             if (args == "-c") {
-                if (++n > argc) error();
+                if (++n >= argc) error();
                 xtiled.tileCount = atoi(argv[n]);
                 continue;
             }
             
             if (args == "-s") {
-                if (++n > argc) error();
+                if (++n >= argc) error();
                 xtiled.similarityPercentage = atof(argv[n]);
                 continue;
             }
             
+            if (args == "-j") {
+                if (++n >= argc) error();
+                int threads = atoi(argv[n]);
+                if (threads <= 0) {
+                    std::cout << MessageType::Error << "-j needs a number of threads of at least 1.\n";
+                    return -1;
+                }
+                xtiled.threads = threads;
+                continue;
+            }
+            
+            if (args == "--flip") {
+                xtiled.matchFlips = true;
+                continue;
+            }
+            
+            if (args == "--stats" || args == "--stats=text" || args == "--stats=json") {
+                stats_format = args == "--stats=json" ? "json" : "text";
+                continue;
+            }
+            
+            if (args == "--trace") {
+                if (++n >= argc) error();
+                trace_filename = std::filesystem::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--indexed") {
+                xtiled.indexedColour = true;
+                continue;
+            }
+            
+            if (args == "--stream") {
+                xtiled.streaming = true;
+                continue;
+            }
+            
+            if (args == "--index") {
+                if (++n >= argc) error();
+                xtiled.indexFile = std::filesystem::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--tileset") {
+                if (++n >= argc) error();
+                xtiled.tilesetFile = std::filesystem::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--margin") {
+                if (++n >= argc) error();
+                int margin = atoi(argv[n]);
+                if (margin < 0) {
+                    std::cout << MessageType::Error << "--margin can not be negative.\n";
+                    return -1;
+                }
+                xtiled.tilesetMargin = margin;
+                continue;
+            }
+            
+            if (args == "--spacing") {
+                if (++n >= argc) error();
+                int spacing = atoi(argv[n]);
+                if (spacing < 0) {
+                    std::cout << MessageType::Error << "--spacing can not be negative.\n";
+                    return -1;
+                }
+                xtiled.tilesetSpacing = spacing;
+                continue;
+            }
+            
+            if (args == "--no-append") {
+                xtiled.appendUnknownTiles = false;
+                continue;
+            }
+            
+            if (args == "--update") {
+                if (++n >= argc) error();
+                previous_filename = std::filesystem::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--chunk-size") {
+                if (++n >= argc) error();
+                int chunkSize = atoi(argv[n]);
+                if (chunkSize < 0) {
+                    std::cout << MessageType::Error << "--chunk-size can not be negative.\n";
+                    return -1;
+                }
+                xtiled.chunkSize = chunkSize;
+                continue;
+            }
+            
+            if (args == "--layer-encoding") {
+                if (++n >= argc) error();
+                std::string encoding(argv[n]);
+                if (encoding == "csv") xtiled.layerEncoding = LayerEncoding::CSV;
+                else if (encoding == "base64") xtiled.layerEncoding = LayerEncoding::Base64;
+                else if (encoding == "zlib") xtiled.layerEncoding = LayerEncoding::Zlib;
+                else if (encoding == "gzip") xtiled.layerEncoding = LayerEncoding::Gzip;
+                else if (encoding == "zstd") xtiled.layerEncoding = LayerEncoding::Zstd;
+                else error();
+                if (!xTiled::isLayerEncodingSupported(xtiled.layerEncoding)) {
+                    std::cout << MessageType::Error << "Layer encoding '" << encoding << "' is not supported by this build.\n";
+                    return -1;
+                }
+                continue;
+            }
+            
             
             if (args == "-help") {
                 help();
@@ -216,6 +381,64 @@ int main(int argc, const char * argv[])
         }
     
         in_filename = std::filesystem::expand_tilde(argv[n]);
+        in_filenames.push_back(in_filename);
+    }
+    
+    if (xtiled.indexedColour && !previous_filename.empty()) {
+        std::cout << MessageType::Error << "--indexed can not be used with --update.\n";
+        return -1;
+    }
+    
+    if (!xtiled.tilesetFile.empty() && (!xtiled.indexFile.empty() || !previous_filename.empty())) {
+        std::cout << MessageType::Error << "--tileset can not be used with --index or --update.\n";
+        return -1;
+    }
+    
+    if (batch && in_filenames.empty()) error();
+    
+    if (!stats_format.empty()) {
+        ConversionStats::enable();
+    }
+    
+    if (!trace_filename.empty()) {
+        Trace::start(trace_filename);
+    }
+    ExitReport report = {stats_format == "json"};
+    
+    if (batch) {
+        info();
+        
+        if (xtiled.streaming || !previous_filename.empty()) {
+            std::cout << MessageType::Error << "--stream and --update can not be used with batch.\n";
+            return -1;
+        }
+        
+        // Each tmj file is named after its input, so two inputs with the same name would write the same file.
+        std::map<std::string, std::string> tmjfiles;
+        for (const auto& filename : in_filenames) {
+            if (!fileExists(filename)) {
+                std::cout << MessageType::Error << "File '" << filename << "' not found.\n";
+                return -1;
+            }
+            
+            std::string tmjfile = std::filesystem::path(filename).filename().replace_extension("tmj");
+            auto [it, added] = tmjfiles.emplace(tmjfile, filename);
+            if (!added) {
+                std::cout << MessageType::Error << "Files '" << it->second << "' and '" << filename << "' would both be saved as '" << tmjfile << "'.\n";
+                return -1;
+            }
+        }
+        
+        std::string directory = out_filename.empty() ? "." : std::filesystem::expand_tilde(out_filename);
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            std::cout << MessageType::Error << "Unable to create directory '" << directory << "'.\n";
+            return -1;
+        }
+        
+        bool success = xtiled.generateTMJBatch(in_filenames, directory);
+        return success ? 0 : -1;
     }
     
     if (std::filesystem::path(in_filename).parent_path().empty()) {
@@ -241,10 +464,16 @@ int main(int argc, const char * argv[])
     }
     
     
-    xtiled.generateTMJData();
-    xtiled.createTMJFile(out_filename);
+    if (!previous_filename.empty()) {
+        if (!xtiled.updateTMJData(previous_filename, out_filename)) {
+            return -1;
+        }
+    } else if (!xtiled.generateTMJData()) {
+        return -1;
+    }
     
+    bool success = xtiled.createTMJFile(out_filename);
     
-    return 0;
+    return success ? 0 : -1;
 }
 
@@ -0,0 +1,64 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "palette.hpp"
+
+#include <cstring>
+
+int ColourPalette::indexOf(uint32_t colour) {
+    if ((colour >> 24) == 0) colour = 0;
+    
+    auto it = _lookup.find(colour);
+    if (it != _lookup.end())
+        return it->second;
+    
+    if (_colours.size() == kMaxColours)
+        return -1;
+    
+    _lookup.emplace(colour, (uint8_t)_colours.size());
+    _colours.push_back(colour);
+    return (int)_colours.size() - 1;
+}
+
+bool ColourPalette::indexPixels(const uint8_t* pixels, uint8_t* indices, size_t count) {
+    // Neighbouring pixels are usually the same colour, so the last lookup is kept.
+    uint32_t last = 0;
+    int lastIndex = -1;
+    
+    for (size_t i = 0; i < count; i++) {
+        uint32_t colour;
+        memcpy(&colour, pixels + i * 4, sizeof(colour));
+        
+        if (colour != last || lastIndex < 0) {
+            lastIndex = indexOf(colour);
+            if (lastIndex < 0)
+                return false;
+            last = colour;
+        }
+        
+        // Each index is written at or before the pixel it replaces, so converting in place is safe.
+        indices[i] = (uint8_t)lastIndex;
+    }
+    
+    return true;
+}
@@ -0,0 +1,79 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#ifndef palette_hpp
+#define palette_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+ The colours of an indexed colour image, at most 256 of them, each kept as RGBA bytes in memory
+ order. Colours are given the next free index the first time they are seen, so converting images to
+ indices is lossless for as long as they use no more than 256 colours between them.
+ */
+class ColourPalette {
+public:
+    static constexpr size_t kMaxColours = 256;
+    
+    void clear(void) {
+        _colours.clear();
+        _lookup.clear();
+    }
+    
+    size_t size(void) const {
+        return _colours.size();
+    }
+    
+    const std::vector<uint32_t>& colours(void) const {
+        return _colours;
+    }
+    
+    uint32_t colour(uint8_t index) const {
+        return _colours[index];
+    }
+    
+    /**
+     @brief    Returns the index of a colour, adding it to the palette if it is not already there.
+     @return   The index, or -1 if the palette is full.
+     */
+    int indexOf(uint32_t colour);
+    
+    /**
+     @brief    Converts RGBA pixels to indices into the palette, adding new colours as they are found.
+               Every fully transparent pixel is given the same index, as its colour is never seen.
+     @param    pixels The pixels, 4 bytes each.
+     @param    indices The indices, one byte each, it may be the same buffer as pixels.
+     @param    count The number of pixels.
+     @return   false if the palette became full.
+     */
+    bool indexPixels(const uint8_t* pixels, uint8_t* indices, size_t count);
+    
+private:
+    std::vector<uint32_t> _colours;
+    std::unordered_map<uint32_t, uint8_t> _lookup;
+};
+
+#endif /* palette_hpp */
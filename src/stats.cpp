@@ -0,0 +1,123 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "stats.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sys/resource.h>
+
+static const char* phaseNames[] = {"decode", "matching", "tilesetAssembly", "pngEncode", "tmjWrite"};
+static const char* phaseLabels[] = {"Decode", "Tile matching", "Tileset assembly", "PNG encode", "TMJ write"};
+static const char* counterNames[] = {"tilesScanned", "uniqueTiles", "compareCalls", "bytesCompared", "hashCollisions"};
+static const char* counterLabels[] = {"Tiles scanned", "Unique tiles", "Compare calls", "Bytes compared", "Hash collisions"};
+
+// Time not in any phase is charged to slot PhaseCount, reported as other.
+static double wallSeconds[ConversionStats::PhaseCount + 1];
+static double cpuSeconds[ConversionStats::PhaseCount + 1];
+static int currentPhase = ConversionStats::PhaseCount;
+static std::chrono::steady_clock::time_point lastWall;
+static std::clock_t lastCPU;
+
+static uint64_t peakResidentBytes(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+void ConversionStats::enable(void) {
+    _enabled = true;
+    lastWall = std::chrono::steady_clock::now();
+    lastCPU = std::clock();
+}
+
+void ConversionStats::switchPhase(int phase) {
+    auto wall = std::chrono::steady_clock::now();
+    std::clock_t cpu = std::clock();
+    wallSeconds[currentPhase] += std::chrono::duration<double>(wall - lastWall).count();
+    cpuSeconds[currentPhase] += (double)(cpu - lastCPU) / CLOCKS_PER_SEC;
+    lastWall = wall;
+    lastCPU = cpu;
+    currentPhase = phase;
+}
+
+ConversionStats::Scope::Scope(Phase phase) {
+    if (!_enabled)
+        return;
+    _previous = currentPhase;
+    switchPhase(phase);
+}
+
+ConversionStats::Scope::~Scope() {
+    if (_previous >= 0) switchPhase(_previous);
+}
+
+void ConversionStats::report(std::ostream& output, bool json) {
+    if (!_enabled)
+        return;
+    switchPhase(currentPhase);
+    
+    double totalWall = 0.0, totalCPU = 0.0;
+    for (int p = 0; p <= PhaseCount; p++) {
+        totalWall += wallSeconds[p];
+        totalCPU += cpuSeconds[p];
+    }
+    
+    std::ios state(nullptr);
+    state.copyfmt(output);
+    output << std::fixed << std::setprecision(6);
+    
+    if (json) {
+        output << "{\n  \"phases\": {\n";
+        for (int p = 0; p <= PhaseCount; p++) {
+            output << "    \"" << (p < PhaseCount ? phaseNames[p] : "other") << "\": {\"wallSeconds\": " << wallSeconds[p]
+                   << ", \"cpuSeconds\": " << cpuSeconds[p] << "},\n";
+        }
+        output << "    \"total\": {\"wallSeconds\": " << totalWall << ", \"cpuSeconds\": " << totalCPU << "}\n  },\n";
+        output << "  \"counters\": {\n";
+        for (int c = 0; c < CounterCount; c++) {
+            output << "    \"" << counterNames[c] << "\": " << _counters[c].load() << ",\n";
+        }
+        output << "    \"peakResidentBytes\": " << peakResidentBytes() << "\n  }\n}\n";
+    } else {
+        output << std::left << std::setw(20) << "Phase" << std::right << std::setw(12) << "Wall (s)" << std::setw(12) << "CPU (s)" << "\n";
+        for (int p = 0; p <= PhaseCount; p++) {
+            output << std::left << std::setw(20) << (p < PhaseCount ? phaseLabels[p] : "Other") << std::right
+                   << std::setw(12) << wallSeconds[p] << std::setw(12) << cpuSeconds[p] << "\n";
+        }
+        output << std::left << std::setw(20) << "Total" << std::right << std::setw(12) << totalWall << std::setw(12) << totalCPU << "\n\n";
+        for (int c = 0; c < CounterCount; c++) {
+            output << std::left << std::setw(20) << counterLabels[c] << std::right << std::setw(12) << _counters[c].load() << "\n";
+        }
+        output << std::left << std::setw(20) << "Peak RSS (MiB)" << std::right << std::setprecision(1) << std::setw(12)
+               << (double)peakResidentBytes() / (1024.0 * 1024.0) << "\n";
+    }
+    
+    output.copyfmt(state);
+}
@@ -0,0 +1,104 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#ifndef stats_hpp
+#define stats_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+/*
+ Timings and counters for a conversion, reported with --stats. Time is charged to the innermost phase
+ in effect, so a phase nested inside another, such as decoding the tileset while the tileset is
+ being prepared, is not counted twice. Phases are only entered from the main thread, the CPU time of
+ a phase includes every worker thread it runs. Nothing is recorded unless stats are enabled.
+ */
+class ConversionStats {
+public:
+    enum Phase {
+        Decode,             // Reading and decoding PNG files
+        Matching,           // Classifying, hashing and matching the cells
+        TilesetAssembly,    // Preparing the tileset and assembling the atlas
+        PNGEncode,          // Encoding and writing the tileset PNG
+        TMJWrite,           // Writing the TMJ files
+        PhaseCount
+    };
+    
+    enum Counter {
+        TilesScanned,       // Cells matched
+        UniqueTiles,        // Tiles in the tileset
+        CompareCalls,       // Tile compares, exact and similarity
+        BytesCompared,      // Bytes of the tiles given to those compares
+        HashCollisions,     // Exact compares of tiles with the same hash that differ
+        CounterCount
+    };
+    
+    /**
+     @brief    Enables stats, time from now on is charged to the phases.
+     */
+    static void enable(void);
+    
+    static bool isEnabled(void) {
+        return _enabled;
+    }
+    
+    static void add(Counter counter, uint64_t value) {
+        if (_enabled) _counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+    
+    static void set(Counter counter, uint64_t value) {
+        if (_enabled) _counters[counter].store(value, std::memory_order_relaxed);
+    }
+    
+    /**
+     @brief    Writes the timings, counters and peak resident set size.
+     @param    output The stream to write to.
+     @param    json Write a JSON object rather than text.
+     */
+    static void report(std::ostream& output, bool json);
+    
+    /*
+     Charges the time until it goes out of scope to a phase.
+     */
+    class Scope {
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+        
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        
+    private:
+        int _previous = -1;
+    };
+    
+private:
+    // Charges the time since the last switch to the current phase, then makes phase current.
+    static void switchPhase(int phase);
+    
+    static inline bool _enabled = false;
+    static inline std::atomic<uint64_t> _counters[CounterCount] = {};
+};
+
+#endif /* stats_hpp */
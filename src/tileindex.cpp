@@ -0,0 +1,141 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "tileindex.hpp"
+#include "stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+uint32_t TileSimilarityIndex::distance(const TImageView& a, const TImageView& b) const {
+    uint32_t lengthInBytes = (uint32_t)a.width * a.height * (a.bitWidth / 8);
+    ConversionStats::add(ConversionStats::CompareCalls, 1);
+    ConversionStats::add(ConversionStats::BytesCompared, lengthInBytes);
+    return lengthInBytes - (uint32_t)_kernels->matchCount(a, b);
+}
+
+void TileSimilarityIndex::add(const TImageView& tile) {
+    int slot = size();
+    if (slot == 0) _kernels = &selectTileKernels(tile.width, tile.height, tile.bitWidth);
+    _tiles.push_back(tile);
+    _distances.resize(_distances.size() + kMaxPivots, 0);
+    
+    uint32_t* d = &_distances[slot * kMaxPivots];
+    uint32_t nearest = UINT32_MAX;
+    for (size_t i = 0; i < _pivots.size(); i++) {
+        d[i] = distance(tile, _tiles[_pivots[i]]);
+        _groups[i][d[i]].push_back(slot);
+        if (nearest > d[i]) nearest = d[i];
+    }
+    
+    // A tile that differs from every pivot in at least half of its bytes becomes a pivot itself,
+    // which spreads the pivots across the tileset.
+    uint32_t lengthInBytes = (uint32_t)tile.width * tile.height * (tile.bitWidth / 8);
+    if (_pivots.size() < kMaxPivots && (_pivots.empty() || nearest >= lengthInBytes / 2)) {
+        int pivot = (int)_pivots.size();
+        _pivots.push_back(slot);
+        _groups[pivot].assign(lengthInBytes + 1, {});
+        for (int s = 0; s <= slot; s++) {
+            uint32_t distanceToPivot = s == slot ? 0 : distance(_tiles[s], tile);
+            _distances[s * kMaxPivots + pivot] = distanceToPivot;
+            _groups[pivot][distanceToPivot].push_back(s);
+        }
+    }
+}
+
+int TileSimilarityIndex::find(const TImageView& tile, float similarityPercentage) const {
+    if (_tiles.empty())
+        return -1;
+    
+    // The largest distance a match can have. Rounded up so that the bound never rejects a tile
+    // that the exact compare would accept.
+    uint32_t lengthInBytes = (uint32_t)tile.width * tile.height * (tile.bitWidth / 8);
+    double allowed = std::floor((1.0 - (double)similarityPercentage) * lengthInBytes) + 1.0;
+    uint32_t maxDistance = allowed < 0.0 ? 0 : (uint32_t)allowed;
+    
+    // Only the groups from queryDistance - maxDistance to queryDistance + maxDistance of a pivot can
+    // hold a match. The pivot with the fewest slots in that range gives the candidates.
+    uint32_t queryDistances[kMaxPivots];
+    uint32_t first[kMaxPivots], last[kMaxPivots];
+    size_t nearest = 0, nearestCount = SIZE_MAX;
+    for (size_t i = 0; i < _pivots.size(); i++) {
+        queryDistances[i] = distance(tile, _tiles[_pivots[i]]);
+        first[i] = queryDistances[i] > maxDistance ? queryDistances[i] - maxDistance : 0;
+        last[i] = std::min<uint32_t>(queryDistances[i] + maxDistance, (uint32_t)_groups[i].size() - 1);
+        
+        size_t count = 0;
+        for (uint32_t group = first[i]; group <= last[i] && count < nearestCount; group++) {
+            count += _groups[i][group].size();
+        }
+        if (count < nearestCount) {
+            nearest = i;
+            nearestCount = count;
+        }
+    }
+    
+    auto inRange = [&](int slot) {
+        const uint32_t* d = &_distances[slot * kMaxPivots];
+        for (size_t i = 0; i < _pivots.size(); i++) {
+            uint32_t bound = d[i] > queryDistances[i] ? d[i] - queryDistances[i] : queryDistances[i] - d[i];
+            if (bound > maxDistance)
+                return false;
+        }
+        return true;
+    };
+    
+    // The other pivots rule out what they can, the rest are compared in slot order so the first
+    // match is the one a scan of every slot finds. When the range holds most of the slots, as it
+    // does for tiles with little in common, scanning every slot in order is cheaper than gathering
+    // and sorting them.
+    if (nearestCount * 4 > (size_t)size()) {
+        for (int slot = 0; slot < size(); slot++) {
+            if (!inRange(slot))
+                continue;
+            
+            ConversionStats::add(ConversionStats::CompareCalls, 1);
+            ConversionStats::add(ConversionStats::BytesCompared, lengthInBytes);
+            if (_kernels->atLeast(_tiles[slot], tile, similarityPercentage))
+                return slot;
+        }
+        return -1;
+    }
+    
+    std::vector<int> candidates;
+    candidates.reserve(nearestCount);
+    for (uint32_t group = first[nearest]; group <= last[nearest]; group++) {
+        for (int slot : _groups[nearest][group]) {
+            if (inRange(slot)) candidates.push_back(slot);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    
+    for (int slot : candidates) {
+        ConversionStats::add(ConversionStats::CompareCalls, 1);
+        ConversionStats::add(ConversionStats::BytesCompared, lengthInBytes);
+        if (_kernels->atLeast(_tiles[slot], tile, similarityPercentage))
+            return slot;
+    }
+    
+    return -1;
+}
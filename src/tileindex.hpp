@@ -0,0 +1,86 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+
+#ifndef tileindex_hpp
+#define tileindex_hpp
+
+#include "image.hpp"
+#include <vector>
+
+/*
+ An index for similarity matching of tiles, where the distance between two tiles is the number of
+ bytes that differ. That distance is a metric, so the distances from a tile to a handful of pivot
+ tiles bound its distance to every other tile by the triangle inequality:
+ 
+     |d(q, p) - d(s, p)| <= d(q, s)
+ 
+ Each tile stores its distance to every pivot, and for each pivot the tiles are grouped by their
+ distance to it. A query computes its own distances to the pivots, which leaves only the groups within
+ range of them, so the tiles of every other group are ruled out without being visited. Bytes are only
+ compared for the tiles whose bound does not rule them out, in slot order, so the result is always
+ the same as a brute-force scan.
+ */
+class TileSimilarityIndex {
+public:
+    static constexpr int kMaxPivots = 8;
+    
+    void clear(void) {
+        _tiles.clear();
+        _distances.clear();
+        _pivots.clear();
+        for (auto& groups : _groups) groups.clear();
+        _kernels = nullptr;
+    }
+    
+    int size(void) const {
+        return (int)_tiles.size();
+    }
+    
+    /**
+     @brief    Adds a tile to the index, the tile is given the next slot.
+     @param    tile A view of the tile, the pixels must stay valid for as long as the index is used.
+     */
+    void add(const TImageView& tile);
+    
+    /**
+     @brief    Finds the first slot whose similarity to the tile reaches the threshold.
+     @param    tile The tile to be matched.
+     @param    similarityPercentage The minimum similarity, from 0.0 to 1.0, required for a match.
+     @return   The slot of the first matching tile, or -1 if no tile matches.
+     */
+    int find(const TImageView& tile, float similarityPercentage) const;
+    
+private:
+    uint32_t distance(const TImageView& a, const TImageView& b) const;
+    
+    std::vector<TImageView> _tiles;
+    std::vector<uint32_t> _distances;   // kMaxPivots distances per slot
+    std::vector<int> _pivots;           // Slots used as pivots
+    
+    // For each pivot, the slots at each distance from it, in slot order
+    std::vector<std::vector<int>> _groups[kMaxPivots];
+    const TTileKernels* _kernels = nullptr; // Selected for the shape of the first tile added
+};
+
+#endif /* tileindex_hpp */
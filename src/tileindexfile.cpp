@@ -0,0 +1,100 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "tileindexfile.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+/*
+ Layout, in host byte order:
+ 
+     char[4]   "XTIX"
+     uint32    version
+     uint32    tile width, tile height, tile count, bit width
+     uint32    length of the tileset file path, followed by the path
+     uint32    number of tiles, followed by a uint64 hash per tile
+ 
+ The version changes whenever the layout or the tile hash function changes, so an index written by
+ a different version is never trusted.
+ */
+static const char kMagic[4] = {'X', 'T', 'I', 'X'};
+static const uint32_t kVersion = 1;
+
+// Upper limits used to reject a corrupt file before allocating for it.
+static const uint32_t kMaxPathLength = 1 << 16;
+static const uint32_t kMaxTiles = 1 << 24;
+
+static bool readValue(FILE* fp, uint32_t& value) {
+    return fread(&value, sizeof(value), 1, fp) == 1;
+}
+
+static bool writeValue(FILE* fp, uint32_t value) {
+    return fwrite(&value, sizeof(value), 1, fp) == 1;
+}
+
+bool readTileIndexFile(const std::string& filename, TTileIndexFile& index) {
+    FILE* fp = fopen(filename.c_str(), "rb");
+    if (!fp)
+        return false;
+    
+    char magic[4];
+    uint32_t version, bitWidth, length, count;
+    bool success = fread(magic, sizeof(magic), 1, fp) == 1 && memcmp(magic, kMagic, sizeof(magic)) == 0 &&
+        readValue(fp, version) && version == kVersion &&
+        readValue(fp, index.tileWidth) && readValue(fp, index.tileHeight) && readValue(fp, index.tileCount) &&
+        readValue(fp, bitWidth) && readValue(fp, length) && length <= kMaxPathLength;
+    
+    if (success) {
+        index.bitWidth = (uint8_t)bitWidth;
+        index.tilesetFile.resize(length);
+        success = fread(index.tilesetFile.data(), 1, length, fp) == length &&
+            readValue(fp, count) && count <= kMaxTiles;
+    }
+    
+    if (success) {
+        index.hashes.resize(count);
+        success = fread(index.hashes.data(), sizeof(uint64_t), count, fp) == count;
+    }
+    
+    fclose(fp);
+    return success;
+}
+
+bool writeTileIndexFile(const std::string& filename, const TTileIndexFile& index) {
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+        return false;
+    
+    bool success = fwrite(kMagic, sizeof(kMagic), 1, fp) == 1 &&
+        writeValue(fp, kVersion) &&
+        writeValue(fp, index.tileWidth) && writeValue(fp, index.tileHeight) && writeValue(fp, index.tileCount) &&
+        writeValue(fp, index.bitWidth) &&
+        writeValue(fp, (uint32_t)index.tilesetFile.size()) &&
+        fwrite(index.tilesetFile.data(), 1, index.tilesetFile.size(), fp) == index.tilesetFile.size() &&
+        writeValue(fp, (uint32_t)index.hashes.size()) &&
+        fwrite(index.hashes.data(), sizeof(uint64_t), index.hashes.size(), fp) == index.hashes.size();
+    
+    if (fclose(fp) != 0) success = false;
+    return success;
+}
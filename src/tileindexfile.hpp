@@ -0,0 +1,59 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#ifndef tileindexfile_hpp
+#define tileindexfile_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ The tile index saved between runs, so that a map can be converted against the tileset built by an
+ earlier run. It records the settings the tileset was built with, where the tileset image was saved
+ and the content hash of every tile in it, in GID order.
+ */
+struct TTileIndexFile {
+    uint32_t tileWidth = 0;
+    uint32_t tileHeight = 0;
+    uint32_t tileCount = 0;
+    uint8_t bitWidth = 0;
+    std::string tilesetFile;
+    std::vector<uint64_t> hashes;   // hashes[0] is the hash of the tile with GID 1
+};
+
+/**
+ @brief    Reads a tile index file.
+ @param    filename The index file.
+ @param    index The index read from the file.
+ @return   false if the file could not be read or is not a tile index file of this version.
+ */
+bool readTileIndexFile(const std::string& filename, TTileIndexFile& index);
+
+/**
+ @brief    Writes a tile index file, replacing any existing file.
+ @return   true on success.
+ */
+bool writeTileIndexFile(const std::string& filename, const TTileIndexFile& index);
+
+#endif /* tileindexfile_hpp */
@@ -0,0 +1,96 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "tilestore.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+bool TileStore::create(int tileWidth, int tileHeight, int bitWidth, int capacity) {
+    release();
+    
+    size_t bytesPerTile = (size_t)tileWidth * tileHeight * (bitWidth / 8);
+    bytesPerTile = (bytesPerTile + kAlignment - 1) & ~(kAlignment - 1);
+    
+    _data = (uint8_t *)std::aligned_alloc(kAlignment, bytesPerTile * capacity);
+    if (!_data)
+        return false;
+    memset(_data, 0, bytesPerTile * capacity);
+    
+    _bytesPerTile = bytesPerTile;
+    _tileWidth = tileWidth;
+    _tileHeight = tileHeight;
+    _bitWidth = bitWidth;
+    _kernels = &selectTileKernels(tileWidth, tileHeight, bitWidth);
+    _slotUsed.assign(capacity, false);
+    _nextFreeSlot = 0;
+    
+    return true;
+}
+
+void TileStore::release(void) {
+    if (_data) std::free(_data);
+    _data = nullptr;
+    _slotUsed.clear();
+    _nextFreeSlot = 0;
+}
+
+int TileStore::append(const TImageView& tile) {
+    if (!fits(tile))
+        return -1;
+    
+    while (_nextFreeSlot < capacity() && _slotUsed[_nextFreeSlot]) {
+        _nextFreeSlot++;
+    }
+    if (_nextFreeSlot == capacity())
+        return -1;
+    
+    int slot = _nextFreeSlot++;
+    store(slot, tile);
+    return slot;
+}
+
+bool TileStore::store(int slot, const TImageView& tile) {
+    if (slot < 0 || slot >= capacity() || !fits(tile))
+        return false;
+    
+    _kernels->copy(_data + _bytesPerTile * slot, (size_t)_tileWidth * (_bitWidth / 8), tile);
+    _slotUsed[slot] = true;
+    return true;
+}
+
+TImage *TileStore::createAtlas(int columns, int rows, int margin, int spacing) const {
+    TImage* atlas = createPixmap(margin * 2 + _tileWidth * columns + spacing * (columns - 1),
+                                 margin * 2 + _tileHeight * rows + spacing * (rows - 1), _bitWidth);
+    if (!atlas)
+        return nullptr;
+    
+    int count = columns * rows < capacity() ? columns * rows : capacity();
+    for (int slot = 0; slot < count; slot++) {
+        if (!_slotUsed[slot])
+            continue;
+        copyImageView(atlas, margin + slot % columns * (_tileWidth + spacing), margin + slot / columns * (_tileHeight + spacing), view(slot));
+    }
+    
+    return atlas;
+}
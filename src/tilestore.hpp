@@ -0,0 +1,120 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+
+#ifndef tilestore_hpp
+#define tilestore_hpp
+
+#include "image.hpp"
+#include <vector>
+
+/*
+ Storage for the tiles of a tileset. Rather than an atlas, the tiles are kept back to back with each
+ tile's pixels packed row after row and every tile starting on a 64-byte boundary, so comparing a
+ tile reads one contiguous block of memory. The atlas image is only assembled when it is saved.
+ */
+class TileStore {
+public:
+    static constexpr size_t kAlignment = 64;
+    
+    TileStore() = default;
+    TileStore(const TileStore&) = delete;
+    TileStore& operator=(const TileStore&) = delete;
+    
+    ~TileStore() {
+        release();
+    }
+    
+    /**
+     @brief    Allocates storage for the given number of tiles, all slots start out free.
+     @return   true on success.
+     */
+    bool create(int tileWidth, int tileHeight, int bitWidth, int capacity);
+    void release(void);
+    
+    int bitWidth(void) const {
+        return _bitWidth;
+    }
+    
+    /**
+     @brief    Returns the tile kernels for the shape of the tiles, selected when the store is created.
+     */
+    const TTileKernels& kernels(void) const {
+        return *_kernels;
+    }
+    
+    int capacity(void) const {
+        return (int)_slotUsed.size();
+    }
+    
+    bool isSlotUsed(int slot) const {
+        return _slotUsed[slot];
+    }
+    
+    /**
+     @brief    Returns a view of the tile in the given slot.
+     */
+    TImageView view(int slot) const {
+        return {_data + _bytesPerTile * slot, (size_t)_tileWidth * (_bitWidth / 8), (uint32_t)_tileWidth, (uint32_t)_tileHeight, (uint8_t)_bitWidth};
+    }
+    
+    /**
+     @brief    Copies a tile into the first free slot.
+     @return   The slot used, or -1 if every slot is in use or the tile is not the shape of the store's tiles.
+     */
+    int append(const TImageView& tile);
+    
+    /**
+     @brief    Copies a tile into a specific slot and marks the slot as used.
+     @return   false if the slot is out of range or the tile is not the shape of the store's tiles.
+     */
+    bool store(int slot, const TImageView& tile);
+    
+    /**
+     @brief    Assembles the tiles into an atlas image, slot by slot from the top-left, left to right.
+     @param    columns The number of tiles per row of the atlas.
+     @param    rows The number of rows of tiles in the atlas.
+     @param    margin The number of pixels around the edge of the atlas.
+     @param    spacing The number of pixels between neighbouring tiles.
+     @return   The atlas image, or nullptr on failure.
+     */
+    TImage *createAtlas(int columns, int rows, int margin = 0, int spacing = 0) const;
+    
+private:
+    bool fits(const TImageView& tile) const {
+        return tile.width == (uint32_t)_tileWidth && tile.height == (uint32_t)_tileHeight && tile.bitWidth == _bitWidth;
+    }
+    
+    uint8_t* _data = nullptr;
+    size_t _bytesPerTile = 0;
+    int _tileWidth = 0;
+    int _tileHeight = 0;
+    int _bitWidth = 0;
+    const TTileKernels* _kernels = &selectTileKernels(0, 0, 0);
+    
+    // Occupancy of each slot and the first slot that may be free
+    std::vector<bool> _slotUsed;
+    int _nextFreeSlot = 0;
+};
+
+#endif /* tilestore_hpp */
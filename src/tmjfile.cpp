@@ -0,0 +1,387 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "tmjfile.hpp"
+#include "base64.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+#include "zlib.h"
+#ifdef XTILED_ZSTD
+#include <zstd.h>
+#endif
+
+/*
+ A minimal JSON reader. Rather than building a document, objects and arrays call back for each
+ member or element, so the layer data of a large map is decoded straight into the GID grid.
+ */
+class JSONReader {
+public:
+    JSONReader(const char* text, size_t length) : _p(text), _end(text + length) {}
+    
+    bool object(const std::function<bool(const std::string& key)>& member) {
+        if (!consume('{'))
+            return false;
+        if (consume('}'))
+            return true;
+        do {
+            std::string key;
+            if (!string(key) || !consume(':') || !member(key))
+                return false;
+        } while (consume(','));
+        return consume('}');
+    }
+    
+    bool array(const std::function<bool(void)>& element) {
+        if (!consume('['))
+            return false;
+        if (consume(']'))
+            return true;
+        do {
+            if (!element())
+                return false;
+        } while (consume(','));
+        return consume(']');
+    }
+    
+    bool string(std::string& value) {
+        if (!consume('"'))
+            return false;
+        value.clear();
+        while (_p < _end && *_p != '"') {
+            if (*_p == '\\') {
+                if (++_p == _end)
+                    return false;
+                switch (*_p) {
+                    case 'n': value += '\n'; break;
+                    case 't': value += '\t'; break;
+                    case 'r': value += '\r'; break;
+                    case 'b': value += '\b'; break;
+                    case 'f': value += '\f'; break;
+                    case 'u':
+                        // Only needed for names, which are not used, so the code point is dropped.
+                        if (_end - _p < 5)
+                            return false;
+                        _p += 4;
+                        break;
+                    default: value += *_p; break;
+                }
+                _p++;
+                continue;
+            }
+            value += *_p++;
+        }
+        if (_p == _end)
+            return false;
+        _p++;
+        return true;
+    }
+    
+    bool number(double& value) {
+        skipWhitespace();
+        char* end;
+        value = strtod(_p, &end);
+        if (end == _p)
+            return false;
+        _p = end;
+        return true;
+    }
+    
+    bool integer(int& value) {
+        double number;
+        if (!this->number(number))
+            return false;
+        value = (int)number;
+        return true;
+    }
+    
+    bool boolean(bool& value) {
+        skipWhitespace();
+        if (literal("true")) {
+            value = true;
+            return true;
+        }
+        value = false;
+        return literal("false");
+    }
+    
+    bool skip(void) {
+        skipWhitespace();
+        if (_p == _end)
+            return false;
+        switch (*_p) {
+            case '{':
+                return object([this](const std::string&) { return skip(); });
+            case '[':
+                return array([this]() { return skip(); });
+            case '"': {
+                std::string value;
+                return string(value);
+            }
+            case 't':
+            case 'f': {
+                bool value;
+                return boolean(value);
+            }
+            case 'n':
+                return literal("null");
+            default: {
+                double value;
+                return number(value);
+            }
+        }
+    }
+    
+    bool peek(char c) {
+        skipWhitespace();
+        return _p < _end && *_p == c;
+    }
+    
+private:
+    void skipWhitespace(void) {
+        while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r')) _p++;
+    }
+    
+    bool consume(char c) {
+        if (!peek(c))
+            return false;
+        _p++;
+        return true;
+    }
+    
+    bool literal(const char* word) {
+        size_t length = strlen(word);
+        if ((size_t)(_end - _p) < length || memcmp(_p, word, length) != 0)
+            return false;
+        _p += length;
+        return true;
+    }
+    
+    const char* _p;
+    const char* _end;
+};
+
+/*
+ Layer data as it appears in the file, either a CSV array or encoded text, decoded once the
+ encoding and compression of the layer are known.
+ */
+struct TLayerData {
+    std::vector<uint32_t> values;
+    std::string text;
+    bool encoded = false;
+};
+
+static bool readLayerData(JSONReader& json, TLayerData& data) {
+    if (json.peek('"')) {
+        data.encoded = true;
+        return json.string(data.text);
+    }
+    return json.array([&]() {
+        double value;
+        if (!json.number(value))
+            return false;
+        data.values.push_back((uint32_t)value);
+        return true;
+    });
+}
+
+static bool decompressLayerData(std::vector<uint8_t>& data, const std::string& compression, size_t length) {
+    if (compression.empty())
+        return data.size() == length;
+    
+    std::vector<uint8_t> decompressed(length);
+    
+    if (compression == "zlib" || compression == "gzip") {
+        z_stream stream = {};
+        // A window of 15 bits plus 32 detects either the zlib or the gzip wrapper.
+        if (inflateInit2(&stream, 15 + 32) != Z_OK)
+            return false;
+        stream.next_in = data.data();
+        stream.avail_in = (uInt)data.size();
+        stream.next_out = decompressed.data();
+        stream.avail_out = (uInt)decompressed.size();
+        int result = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+        if (result != Z_STREAM_END || stream.avail_out != 0)
+            return false;
+        data.swap(decompressed);
+        return true;
+    }
+    
+#ifdef XTILED_ZSTD
+    if (compression == "zstd") {
+        size_t result = ZSTD_decompress(decompressed.data(), decompressed.size(), data.data(), data.size());
+        if (ZSTD_isError(result) || result != length)
+            return false;
+        data.swap(decompressed);
+        return true;
+    }
+#endif
+    
+    return false;
+}
+
+/*
+ Decodes the layer data of a width x height block of cells into GIDs.
+ */
+static bool decodeLayerData(TLayerData& data, const std::string& encoding, const std::string& compression, int width, int height) {
+    size_t count = (size_t)width * height;
+    if (!data.encoded)
+        return data.values.size() == count;
+    
+    std::vector<uint8_t> bytes;
+    if (encoding != "base64" || !base64Decode(data.text, bytes) || !decompressLayerData(bytes, compression, count * 4))
+        return false;
+    
+    data.values.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* p = bytes.data() + i * 4;
+        data.values[i] = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+    data.text.clear();
+    return true;
+}
+
+struct TChunk {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    TLayerData data;
+};
+
+bool readTMJFile(const std::string& filename, TTMJFile& tmj) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+    
+    JSONReader json(text.data(), text.size());
+    
+    bool infinite = false;
+    bool haveLayer = false;
+    bool haveTileset = false;
+    TLayerData layerData;
+    std::vector<TChunk> chunks;
+    std::string encoding, compression;
+    
+    bool success = json.object([&](const std::string& key) {
+        if (key == "width") return json.integer(tmj.columns);
+        if (key == "height") return json.integer(tmj.rows);
+        if (key == "tilewidth") return json.integer(tmj.tileWidth);
+        if (key == "tileheight") return json.integer(tmj.tileHeight);
+        if (key == "infinite") return json.boolean(infinite);
+        
+        if (key == "layers") {
+            return json.array([&]() {
+                if (haveLayer) return json.skip();
+                
+                // Only the first tile layer is read, other kinds of layer are passed over.
+                std::string type;
+                TLayerData data;
+                std::vector<TChunk> layerChunks;
+                std::string layerEncoding = "csv", layerCompression;
+                
+                bool read = json.object([&](const std::string& key) {
+                    if (key == "type") return json.string(type);
+                    if (key == "data") return readLayerData(json, data);
+                    if (key == "encoding") return json.string(layerEncoding);
+                    if (key == "compression") return json.string(layerCompression);
+                    if (key == "chunks") {
+                        return json.array([&]() {
+                            layerChunks.push_back(TChunk());
+                            return json.object([&](const std::string& key) {
+                                TChunk& chunk = layerChunks.back();
+                                if (key == "x") return json.integer(chunk.x);
+                                if (key == "y") return json.integer(chunk.y);
+                                if (key == "width") return json.integer(chunk.width);
+                                if (key == "height") return json.integer(chunk.height);
+                                if (key == "data") return readLayerData(json, chunk.data);
+                                return json.skip();
+                            });
+                        });
+                    }
+                    return json.skip();
+                });
+                
+                if (read && type == "tilelayer") {
+                    haveLayer = true;
+                    layerData = std::move(data);
+                    chunks = std::move(layerChunks);
+                    encoding = layerEncoding;
+                    compression = layerCompression;
+                }
+                return read;
+            });
+        }
+        
+        if (key == "tilesets") {
+            return json.array([&]() {
+                if (haveTileset) return json.skip();
+                
+                haveTileset = true;
+                return json.object([&](const std::string& key) {
+                    if (key == "image") return json.string(tmj.tilesetImage);
+                    if (key == "columns") return json.integer(tmj.tilesetColumns);
+                    if (key == "tilecount") return json.integer(tmj.tileCount);
+                    return json.skip();
+                });
+            });
+        }
+        
+        return json.skip();
+    });
+    
+    if (!success || !haveLayer || !haveTileset || tmj.columns <= 0 || tmj.rows <= 0)
+        return false;
+    
+    if (!infinite) {
+        if (!decodeLayerData(layerData, encoding, compression, tmj.columns, tmj.rows))
+            return false;
+        tmj.gids = std::move(layerData.values);
+        return true;
+    }
+    
+    tmj.gids.assign((size_t)tmj.columns * tmj.rows, 0);
+    for (auto& chunk : chunks) {
+        if (chunk.width <= 0 || chunk.height <= 0 || !decodeLayerData(chunk.data, encoding, compression, chunk.width, chunk.height))
+            return false;
+        
+        for (int r = 0; r < chunk.height; r++) {
+            int y = chunk.y + r;
+            if (y < 0 || y >= tmj.rows) continue;
+            for (int c = 0; c < chunk.width; c++) {
+                int x = chunk.x + c;
+                if (x < 0 || x >= tmj.columns) continue;
+                tmj.gids[x + (size_t)y * tmj.columns] = chunk.data.values[c + (size_t)r * chunk.width];
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#ifndef tmjfile_hpp
+#define tmjfile_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ The parts of a TMJ map that are needed to convert a map again against the tileset it already uses:
+ its size, the GIDs of its first tile layer and the image of its first tileset.
+ */
+struct TTMJFile {
+    int columns = 0;
+    int rows = 0;
+    int tileWidth = 0;
+    int tileHeight = 0;
+    std::vector<uint32_t> gids;     // GID of every cell, row by row, including any flip flags
+    std::string tilesetImage;       // As written in the file, relative to the file
+    int tilesetColumns = 0;
+    int tileCount = 0;
+};
+
+/**
+ @brief    Reads a TMJ map. CSV, base64, zlib, gzip and, when built with it, zstd layer data are
+           understood, for both fixed size and infinite maps. Cells of an infinite map are read
+           from (0, 0) to the width and height given by the map.
+ @param    filename The TMJ file.
+ @param    tmj The map read from the file.
+ @return   false if the file could not be read or is not a map with a tile layer and a tileset.
+ */
+bool readTMJFile(const std::string& filename, TTMJFile& tmj);
+
+#endif /* tmjfile_hpp */
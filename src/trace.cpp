@@ -0,0 +1,128 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#include "trace.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+typedef struct {
+    const char* name;
+    std::string detail;
+    int64_t start;      // Microseconds since the trace started
+    int64_t duration;   // Microseconds
+    int thread;
+} TTraceEvent;
+
+static std::mutex eventsMutex;
+static std::vector<TTraceEvent> events;
+static std::string traceFile;
+static std::chrono::steady_clock::time_point origin;
+
+// Threads are numbered in the order they first record an event, the main thread is expected to be 0.
+static std::atomic<int> nextThread = 0;
+
+static int currentThread(void) {
+    thread_local int thread = nextThread++;
+    return thread;
+}
+
+static void writeString(FILE* fp, const std::string& s) {
+    fputc('"', fp);
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            fputc('\\', fp);
+            fputc(c, fp);
+        } else if (c < 0x20) {
+            fprintf(fp, "\\u%04x", c);
+        } else {
+            fputc(c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+void Trace::start(const std::string& filename) {
+    traceFile = filename;
+    origin = std::chrono::steady_clock::now();
+    currentThread();
+    _enabled = true;
+}
+
+void Trace::record(const char* name, const std::string& detail, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    TTraceEvent event = {
+        name, detail,
+        std::chrono::duration_cast<std::chrono::microseconds>(start - origin).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+        currentThread()
+    };
+    
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    events.push_back(std::move(event));
+}
+
+bool Trace::finish(void) {
+    if (!_enabled)
+        return true;
+    _enabled = false;
+    
+    FILE* fp = fopen(traceFile.c_str(), "w");
+    if (!fp) {
+        std::cerr << "Error: Unable to open file for writing: " << traceFile << std::endl;
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(eventsMutex);
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    
+    // Names for the threads, workers are short lived so each one is numbered.
+    int threads = nextThread;
+    for (int t = 0; t < threads; t++) {
+        fprintf(fp, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ", t ? ",\n" : "", t);
+        writeString(fp, t == 0 ? "main" : "worker " + std::to_string(t));
+        fprintf(fp, "}}");
+    }
+    
+    for (const TTraceEvent& event : events) {
+        fprintf(fp, ",\n{\"name\": ");
+        writeString(fp, event.name);
+        fprintf(fp, ", \"cat\": \"xtiled\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %lld, \"dur\": %lld",
+                event.thread, (long long)event.start, (long long)event.duration);
+        if (!event.detail.empty()) {
+            fprintf(fp, ", \"args\": {\"detail\": ");
+            writeString(fp, event.detail);
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "}");
+    }
+    
+    fprintf(fp, "\n]}\n");
+    events.clear();
+    
+    bool success = ferror(fp) == 0;
+    fclose(fp);
+    return success;
+}
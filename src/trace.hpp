@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+#ifndef trace_hpp
+#define trace_hpp
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/*
+ Records spans of time, on any thread, in the Chrome trace event format so a conversion can be
+ opened in chrome://tracing or Perfetto, enabled with --trace. While tracing is off a span only tests
+ a flag, so spans are left in place rather than compiled out.
+ */
+class Trace {
+public:
+    /**
+     @brief    Starts recording, the events are written to the file by finish.
+     @param    filename The trace file to write.
+     */
+    static void start(const std::string& filename);
+    
+    /**
+     @brief    Writes the recorded events to the file given to start and stops recording.
+     @return   false if the file could not be written.
+     */
+    static bool finish(void);
+    
+    static bool isEnabled(void) {
+        return _enabled;
+    }
+    
+    /*
+     A complete event covering the lifetime of the span, on the thread that created it.
+     */
+    class Span {
+    public:
+        /**
+         @param    name The name of the span, it must be a string literal.
+         @param    detail Shown as the detail argument of the span, if not empty.
+         */
+        explicit Span(const char* name, const std::string& detail = std::string()) {
+            if (!_enabled)
+                return;
+            _name = name;
+            _detail = detail;
+            _start = std::chrono::steady_clock::now();
+        }
+        
+        /**
+         @param    name The name of the span, it must be a string literal.
+         @param    begin The first of a range of items the span works on, such as rows or cells.
+         @param    end One past the last item of the range.
+         */
+        Span(const char* name, int64_t begin, int64_t end) {
+            if (!_enabled)
+                return;
+            _name = name;
+            _begin = begin;
+            _end = end;
+            _start = std::chrono::steady_clock::now();
+        }
+        
+        ~Span() {
+            if (!_name)
+                return;
+            if (_end > _begin) _detail = std::to_string(_begin) + "-" + std::to_string(_end);
+            record(_name, _detail, _start, std::chrono::steady_clock::now());
+        }
+        
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+        
+    private:
+        const char* _name = nullptr;
+        std::string _detail;
+        int64_t _begin = 0;
+        int64_t _end = 0;
+        std::chrono::steady_clock::time_point _start;
+    };
+    
+private:
+    static void record(const char* name, const std::string& detail, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+    
+    static inline bool _enabled = false;
+};
+
+#endif /* trace_hpp */
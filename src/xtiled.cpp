@@ -21,215 +21,1242 @@
 // SOFTWARE.
 
 #include "xtiled.hpp"
+#include "filewriter.hpp"
+#include "base64.hpp"
+#include "tileindexfile.hpp"
+#include "tmjfile.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <sstream>
 #include <vector>
-#include <regex>
 #include <fstream>
 #include <array>
+#include <filesystem>
+#include <cmath>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <future>
 
 #include <string>
 
-static int* arr;
+#include "zlib.h"
+#ifdef XTILED_ZSTD
+#include <zstd.h>
+#endif
 
 
-static std::string removePath(const std::string& filename) {
-    // Find the last dot in the string
-    size_t pos = filename.find_last_of('/');
+/*
+ Splits count items into contiguous bands, one per thread, and calls fn(begin, end) for each band.
+ With a single thread fn is called on the calling thread.
+ */
+static void parallelForBands(int count, unsigned threads, const std::function<void(int, int)>& fn) {
+    if (threads > (unsigned)count) threads = count;
+    if (threads <= 1) {
+        fn(0, count);
+        return;
+    }
+    
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; t++) {
+        int begin = (int)((long long)count * t / threads);
+        int end = (int)((long long)count * (t + 1) / threads);
+        workers.emplace_back([&fn, begin, end]() {
+            Trace::Span span("band", begin, end);
+            fn(begin, end);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/*
+ Loads a PNG, returning nullptr rather than throwing if it is missing or not a valid PNG.
+ */
+static TImage* loadPNGImage(const std::string& filename) {
+    try {
+        return loadPNGGraphicFile(filename);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
 
-    if (pos == std::string::npos) {
-        return filename;
+/*
+ Opens a PNG for streaming, returning nullptr rather than throwing. The reason is reported, as an
+ image that loads whole, such as an interlaced one, may still fail to stream.
+ */
+static TPNGReader* openPNGReader(const std::string& filename) {
+    try {
+        return openPNGGraphicFile(filename);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return nullptr;
     }
+}
+
+/*
+ Counts an exact compare of two tiles that share a hash for --stats, one that differs is a collision.
+ */
+static void countHashCompare(const TImageView& tile, bool equal) {
+    if (!ConversionStats::isEnabled())
+        return;
+    ConversionStats::add(ConversionStats::CompareCalls, 1);
+    ConversionStats::add(ConversionStats::BytesCompared, (uint64_t)tile.width * tile.height * (tile.bitWidth / 8));
+    if (!equal) ConversionStats::add(ConversionStats::HashCollisions, 1);
+}
+
+static int findTileUID(const TileStore& tiles, const std::unordered_multimap<uint64_t, int>& index, const TImageView& tile, uint64_t hash) {
+    auto range = index.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        bool equal = tiles.kernels().equal(tiles.view(it->second - 1), tile);
+        countHashCompare(tile, equal);
+        if (equal) {
+            return it->second;
+        }
+    }
+    
+    return -1;
+}
 
-    // Return the substring from the beginning up to the last dot
-    return filename.substr(pos + 1, filename.length() - pos - 1);
+static const char* compressionName(LayerEncoding encoding) {
+    switch (encoding) {
+        case LayerEncoding::Zlib:
+            return "zlib";
+        case LayerEncoding::Gzip:
+            return "gzip";
+        case LayerEncoding::Zstd:
+            return "zstd";
+        default:
+            return nullptr;
+    }
 }
 
-static void extractTileFromImage(const TImage* dstImage, const TImage* srcImage, int x, int y, int w, int h) {
-    copyPixmap(dstImage, 0, 0, srcImage, x, y, w, h);
+/*
+ Compresses the layer data for the given encoding, plain base64 leaves the data as it is.
+ */
+static bool compressLayerData(std::vector<uint8_t>& data, LayerEncoding encoding) {
+    std::vector<uint8_t> compressed;
+    
+    switch (encoding) {
+        case LayerEncoding::Zlib: {
+            uLongf length = compressBound(data.size());
+            compressed.resize(length);
+            if (compress2(compressed.data(), &length, data.data(), data.size(), Z_DEFAULT_COMPRESSION) != Z_OK)
+                return false;
+            compressed.resize(length);
+            break;
+        }
+            
+        case LayerEncoding::Gzip: {
+            z_stream stream = {};
+            // A window of 15 bits plus 16 selects the gzip wrapper rather than zlib.
+            if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return false;
+            compressed.resize(deflateBound(&stream, data.size()));
+            stream.next_in = data.data();
+            stream.avail_in = (uInt)data.size();
+            stream.next_out = compressed.data();
+            stream.avail_out = (uInt)compressed.size();
+            int status = deflate(&stream, Z_FINISH);
+            compressed.resize(stream.total_out);
+            deflateEnd(&stream);
+            if (status != Z_STREAM_END)
+                return false;
+            break;
+        }
+            
+#ifdef XTILED_ZSTD
+        case LayerEncoding::Zstd: {
+            compressed.resize(ZSTD_compressBound(data.size()));
+            size_t length = ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), ZSTD_CLEVEL_DEFAULT);
+            if (ZSTD_isError(length))
+                return false;
+            compressed.resize(length);
+            break;
+        }
+#endif
+            
+        case LayerEncoding::Base64:
+            return true;
+            
+        default:
+            return false;
+    }
+    
+    data.swap(compressed);
+    return true;
 }
 
-static int findTileUID(const TImage* tileset, const TImage* tile, float similarityPercentage) {
-    int w = tile->width;
-    int h = tile->height;
+/*
+ Packs a rectangle of GIDs as little-endian 32-bit values, as Tiled expects, compresses them for the
+ given encoding and base64 encodes the result. Cells of the rectangle outside the map are written as 0.
+ */
+static bool encodeLayerData(const uint32_t* gids, int columns, int rows, int x, int y, int w, int h, LayerEncoding encoding, std::string& text) {
+    std::vector<uint8_t> data((size_t)w * h * 4, 0);
+    uint8_t* p = data.data();
+    for (int r = y; r < y + h; r++) {
+        for (int c = x; c < x + w; c++, p += 4) {
+            if (c >= columns || r >= rows)
+                continue;
+            uint32_t gid = gids[c + (size_t)r * columns];
+            p[0] = gid & 0xFF;
+            p[1] = gid >> 8 & 0xFF;
+            p[2] = gid >> 16 & 0xFF;
+            p[3] = gid >> 24;
+        }
+    }
+    
+    if (!compressLayerData(data, encoding))
+        return false;
     
-    int uid = 1;
+    text = base64Encode(data.data(), data.size());
+    return true;
+}
+
+static void writeEncodingFields(FileWriter& tmj, LayerEncoding encoding, std::string_view indent) {
+    if (encoding == LayerEncoding::CSV)
+        return;
     
-    for (int y = 0; y < tileset->height; y += h) {
-        for (int x = 0; x < tileset->width; x += w) {
-            if (compareSubImageSimilarity(tileset, x, y, tile) >= similarityPercentage) {
-                return uid;
+    if (compressionName(encoding)) {
+        tmj << indent << "\"compression\":\"" << compressionName(encoding) << "\",\n";
+    }
+    tmj << indent << "\"encoding\":\"base64\",\n";
+}
+
+/*
+ Writes the "data" field of a tile layer, together with the "compression" and "encoding" fields that
+ describe it, each line starting with the given indent. Rows of CSV data are indented one level more.
+ */
+static bool writeLayerData(FileWriter& tmj, const uint32_t* gids, int columns, int rows, LayerEncoding encoding, std::string_view indent) {
+    if (encoding == LayerEncoding::CSV) {
+        tmj << indent << "\"data\":[\n";
+        for (int r = 0; r < rows; r++) {
+            tmj << indent << "    ";
+            for (int c = 0; c < columns; c++) {
+                tmj << gids[c + (size_t)r * columns];
+                if (c < columns - 1 || r < rows - 1) tmj << ", ";
             }
-            uid++;
+            if (r < rows - 1) tmj << '\n';
         }
+        tmj << "\n" << indent << "],\n";
+        return true;
     }
     
-    return -1;
+    std::string text;
+    if (!encodeLayerData(gids, columns, rows, 0, 0, columns, rows, encoding, text))
+        return false;
+    
+    tmj << indent << "\"data\":\"" << text << "\",\n";
+    writeEncodingFields(tmj, encoding, indent);
+    return true;
 }
 
-static void appendTileToTileset(const TImage* tile, const TImage* tileset) {
-    int w = tile->width;
-    int h = tile->height;
+/*
+ Writes the "chunks" field of an infinite tile layer. Chunks in which every GID is 0 are left out,
+ the rest are encoded in parallel, a batch at a time, and written in order.
+ */
+static bool writeLayerChunks(FileWriter& tmj, const uint32_t* gids, int columns, int rows, int chunkSize, LayerEncoding encoding, unsigned threads, std::string_view indent) {
+    int chunkColumns = (columns + chunkSize - 1) / chunkSize;
+    int chunkRows = (rows + chunkSize - 1) / chunkSize;
+    int chunkCount = chunkColumns * chunkRows;
+    
+    const int kBatchSize = 1024;
+    std::vector<std::string> texts;
+    bool success = true;
+    bool first = true;
     
-    for (int y = 0; y < tileset->height; y += h) {
-        for (int x = 0; x < tileset->width; x += w) {
-            if (containsImage(tileset, x, y, w, h))
+    tmj << indent << "\"chunks\":[";
+    for (int batch = 0; batch < chunkCount; batch += kBatchSize) {
+        int count = std::min(kBatchSize, chunkCount - batch);
+        texts.assign(count, std::string());
+        std::vector<char> failed(count, 0);
+        
+        parallelForBands(count, threads, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                int x = (batch + i) % chunkColumns * chunkSize;
+                int y = (batch + i) / chunkColumns * chunkSize;
+                
+                bool empty = true;
+                for (int r = y; r < std::min(y + chunkSize, rows) && empty; r++) {
+                    for (int c = x; c < std::min(x + chunkSize, columns); c++) {
+                        if (gids[c + (size_t)r * columns]) {
+                            empty = false;
+                            break;
+                        }
+                    }
+                }
+                if (empty)
+                    continue;
+                
+                std::string& text = texts[i];
+                if (encoding == LayerEncoding::CSV) {
+                    text += '[';
+                    for (int r = y; r < y + chunkSize; r++) {
+                        for (int c = x; c < x + chunkSize; c++) {
+                            text += std::to_string(c < columns && r < rows ? gids[c + (size_t)r * columns] : 0u);
+                            if (c < x + chunkSize - 1 || r < y + chunkSize - 1) text += ", ";
+                        }
+                    }
+                    text += ']';
+                } else {
+                    std::string data;
+                    failed[i] = !encodeLayerData(gids, columns, rows, x, y, chunkSize, chunkSize, encoding, data);
+                    text = '"' + data + '"';
+                }
+            }
+        });
+        
+        for (int i = 0; i < count; i++) {
+            if (failed[i]) success = false;
+            if (texts[i].empty())
                 continue;
             
-            copyImageAt(tileset, x, y, tile);
-            return;
+            tmj << (first ? "\n" : ",\n");
+            first = false;
+            tmj << indent << "    {\n"
+                << indent << "        \"data\":" << texts[i] << ",\n"
+                << indent << "        \"height\":" << chunkSize << ",\n"
+                << indent << "        \"width\":" << chunkSize << ",\n"
+                << indent << "        \"x\":" << (batch + i) % chunkColumns * chunkSize << ",\n"
+                << indent << "        \"y\":" << (batch + i) / chunkColumns * chunkSize << "\n"
+                << indent << "    }";
         }
     }
+    tmj << "\n" << indent << "],\n";
+    
+    writeEncodingFields(tmj, encoding, indent);
+    return success;
 }
 
-
 //MARK: - xTiled Method/s
 
-void xTiled::createTMJFile(std::string& filename) {
-    std::ofstream outfile;
+bool xTiled::isLayerEncodingSupported(LayerEncoding encoding) {
+#ifndef XTILED_ZSTD
+    if (encoding == LayerEncoding::Zstd)
+        return false;
+#endif
+    return true;
+}
+
+void xTiled::loadTiledImage(std::string& imagefile) {
+    Trace::Span span("loadTiledImage", imagefile);
+    ConversionStats::Scope scope(ConversionStats::Decode);
     
+    // For indexed colour the image is converted once the tileset is ready, so a tileset that is read
+    // back keeps the indices it was saved with.
+    _imageFile = imagefile;
+    if (streaming) {
+        _reader = openPNGReader(imagefile);
+        return;
+    }
+    _tiledImage = loadPNGImage(imagefile);
+}
+
+void xTiled::seedPalette(const std::string& filename) {
+    std::vector<uint32_t> colours;
+    if (loadPNGPalette(filename, colours)) {
+        for (uint32_t colour : colours) {
+            _palette.indexOf(colour);
+        }
+    }
+}
+
+TImage* xTiled::loadImage(const std::string& filename) {
+    ConversionStats::Scope scope(ConversionStats::Decode);
+    TImage* image = loadPNGImage(filename);
+    if (image && indexedColour) {
+        seedPalette(filename);
+        if (!indexImage(image)) reset(image);
+    }
+    return image;
+}
+
+bool xTiled::indexImage(TImage* image) {
+    if (image->bitWidth != 32 || !_palette.indexPixels(image->data, image->data, (size_t)image->width * image->height)) {
+        std::cerr << "Error: The images use more than " << ColourPalette::kMaxColours << " colours between them, indexed colour can not be used." << std::endl;
+        return false;
+    }
+    
+    image->bitWidth = 8;
+    uint8_t* data = (uint8_t *)realloc(image->data, (size_t)image->width * image->height);
+    if (data) image->data = data;
+    return true;
+}
+
+int xTiled::appendTileToTileset(const TImageView& tile) {
+    if (_tileCount >= (int)tileCount || _tilesetFixed)
+        return 0;
     
-    if (_tileset != nullptr) {
-        saveImageAsPNGFile(_tileset, std::filesystem::path(filename).replace_extension("png"));
+    int slot = _tiles.append(tile);
+    if (slot < 0)
+        return 0;
+    
+    _tileCount++;
+    return slot + 1;
+}
+
+/*
+ Returns Tiled's flip flags for an orientation. Bits 0, 1 and 2 of the orientation are the
+ horizontal, vertical and diagonal flips.
+ */
+static uint32_t flipFlags(int orientation) {
+    return (orientation & 1 ? kFlippedHorizontallyFlag : 0) | (orientation & 2 ? kFlippedVerticallyFlag : 0) | (orientation & 4 ? kFlippedDiagonallyFlag : 0);
+}
+
+/*
+ Returns the orientation that undoes the given one. Every orientation undoes itself apart from the
+ two quarter turns, diagonal plus horizontal (clockwise) and diagonal plus vertical (anticlockwise).
+ */
+static int inverseOrientation(int orientation) {
+    if (orientation == 5) return 6;
+    if (orientation == 6) return 5;
+    return orientation;
+}
+
+static TImageView orientImageView(const TImageView& view, int orientation, uint8_t* buffer) {
+    if (orientation == 0) return view;
+    return flipImageView(view, orientation & 1, orientation & 2, orientation & 4, buffer);
+}
+
+uint64_t xTiled::tileKey(const TImageView& tile, uint8_t* buffer) const {
+    const TTileKernels& kernels = _tiles.kernels();
+    uint64_t key = kernels.hash(tile);
+    for (int orientation = 1; orientation < orientationCount(); orientation++) {
+        key = std::min(key, kernels.hash(orientImageView(tile, orientation, buffer)));
     }
+    return key;
+}
+
+int64_t xTiled::findTile(const TImageView& tile, uint64_t key, uint8_t* buffer) const {
+    if (orientationCount() == 1)
+        return findTileUID(_tiles, _tileIndex, tile, key);
     
-    std::string tmj = R"({ 
-    "compressionlevel":-1,
-    "height":@height,
-    "infinite":false,
-    "layers":[
-        {
-            "data":[
-@layers.data
-            ],
-            "height":@layers.height,
-            "id":1,
-            "name":"@name",
-            "opacity":1,
-            "type":"tilelayer",
-            "visible":true,
-            "width":@layers.width,
-            "x":0,
-            "y":0
-        }
-    ],
-    "nextlayerid":2,
-    "nextobjectid":1,
-    "orientation":"orthogonal",
-    "renderorder":"right-down",
-    "tiledversion":"1.11.0",
-    "tileheight":@tileheight,
-    "tilesets":[
-        {
-            "columns":16,
-            "firstgid":1,
-            "image":"@image",
-            "imageheight":@tilesets.imageheight,
-            "imagewidth":@tilesets.imagewidth,
-            "margin":0,
-            "name":"@name",
-            "spacing":0,
-            "tilecount":@tilesets.tilecount,
-            "tileheight":@tilewidth,
-            "tilewidth":@tilewidth,
-            "transparentcolor":"@tileset.transparentcolor"
-        }
-    ],
-    "tilewidth":@tilewidth,
-    "type":"map",
-    "version":"1.10",
-    "width":@width
-})";
-    
-    std::string name = std::filesystem::path(filename).stem();
-    tmj = regex_replace(tmj, std::regex(R"(@image)"), name.append(".png"));
-    tmj = regex_replace(tmj, std::regex(R"(@name)"), name);
-    
-    
-    tmj = regex_replace(tmj, std::regex(R"(@width)"), std::to_string(_tiledImage->width / tileWidth));
-    tmj = regex_replace(tmj, std::regex(R"(@height)"), std::to_string(_tiledImage->height / tileHeight));
-    tmj = regex_replace(tmj, std::regex(R"(@tilewidth)"), std::to_string(tileWidth));
-    tmj = regex_replace(tmj, std::regex(R"(@tileheight)"), std::to_string(tileHeight));
-    tmj = regex_replace(tmj, std::regex(R"(@tilesets\.imagewidth)"), std::to_string(_tileset->width));
-    tmj = regex_replace(tmj, std::regex(R"(@tilesets\.imageheight)"), std::to_string(_tileset->height));
-    tmj = regex_replace(tmj, std::regex(R"(@tilesets\.tilecount)"), std::to_string(tileCount));
-    tmj = regex_replace(tmj, std::regex(R"(@tilesets\.transparentcolor)"), std::to_string(transparentColor));
-    
-    tmj = regex_replace(tmj, std::regex(R"(@layers\.width)"), std::to_string(_tiledImage->width / tileWidth));
-    tmj = regex_replace(tmj, std::regex(R"(@layers\.height)"), std::to_string(_tiledImage->height / tileHeight));
-    tmj = regex_replace(tmj, std::regex(R"(@layers\.name)"), "Tile Layer");
-    
-    std::ostringstream os;
-    int col = _tiledImage->width / tileWidth;
-    int row = _tiledImage->height / tileHeight;
-    for (int r = 0; r < row; r++) {
-        os << "\t\t\t\t";
-        for (int c = 0; c < col; c++) {
-            os << arr[c + r * col] << ", ";
-        }
-        if (r < row - 1) {
-            os << "\n";
-        }
-    }
-    auto data = os.str();
-    data.resize(data.length() - 2);
-    tmj = regex_replace(tmj, std::regex(R"(@layers\.data)"), data);
-    
-    outfile.open(std::filesystem::path(filename).replace_extension("tmj"), std::ios::out | std::ios::binary);
-    if (outfile.is_open()) {
-        outfile.write(tmj.c_str(), tmj.length());
-        outfile.close();
-    }
-    
-    delete [] arr;
-    
-    std::cout << "✅ TMJ file saved successfully: " << std::filesystem::path(filename).replace_extension("tmj") << std::endl;
-}
-
-void xTiled::generateTMJData(void) {
-    int columnCount = (int)ceil(sqrt((double)tileCount));
-    _tileset = createPixmap(tileWidth * columnCount, tileHeight * columnCount, _tiledImage->bitWidth);
+    // Every tile sharing the key is some orientation of the tile, the unflipped one is tried first.
+    auto range = _tileIndex.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        for (int orientation = 0; orientation < orientationCount(); orientation++) {
+            bool equal = _tiles.kernels().equal(orientImageView(_tiles.view(it->second - 1), orientation, buffer), tile);
+            if (equal || orientation == orientationCount() - 1) countHashCompare(tile, equal);
+            if (equal) {
+                return it->second | flipFlags(orientation);
+            }
+        }
+    }
     
-    _tileCount=1;
+    return -1;
+}
+
+int64_t xTiled::findSimilarTile(const TImageView& tile, uint8_t* buffer) const {
+    for (int orientation = 0; orientation < orientationCount(); orientation++) {
+        // A tile similar to the cell in this orientation shows the cell once flipped the opposite way.
+        int slot = _similarityIndex.find(orientImageView(tile, orientation, buffer), similarityPercentage);
+        if (slot != -1) {
+            return (slot + 1) | flipFlags(inverseOrientation(orientation));
+        }
+    }
     
+    return -1;
+}
+
+bool xTiled::createTMJFile(std::string& filename) {
+    Trace::Span span("createTMJFile", filename);
+    TilesetImage tileset;
     
-    if (_tileset == nullptr) {
+    // An updated map keeps the tileset it was using, which other maps may share.
+    std::string tilesetFile = _mapTilesetFile.empty() ? std::filesystem::path(filename).replace_extension("png").string() : _mapTilesetFile;
+    _mapTilesetFile.clear();
+    if (!saveTilesetImage(tilesetFile, std::filesystem::path(filename).parent_path(), tileset)) {
         std::cout << "ERROR!\n";
-        return;
+        return false;
     }
     
-    TImage* tile = createPixmap(tileWidth, tileHeight, _tiledImage->bitWidth);
+    std::string tmjfile = std::filesystem::path(filename).replace_extension("tmj");
     
-    uint32_t* p = (uint32_t *)tile->data;
-    for (int i = 0; i < tile->width * tile->height; i++) {
-        *p++ = 0xFF000000;
+    ConversionStats::Scope scope(ConversionStats::TMJWrite);
+    bool success = writeTMJFile(tmjfile, _map, tileset, threadCount());
+    _map = TileMap();
+    
+    if (success) {
+        std::cout << "✅ TMJ file saved successfully: " << std::filesystem::path(filename).replace_extension("tmj") << std::endl;
+    }
+    return success;
+}
+
+/*
+ Returns the path of an image relative to the directory of the TMJ files that use it, or its absolute
+ path when there is no relative path.
+ */
+static std::string relativeImagePath(const std::string& filename, const std::string& directory) {
+    std::error_code ec;
+    std::filesystem::path image = std::filesystem::relative(std::filesystem::absolute(filename), std::filesystem::absolute(directory.empty() ? "." : directory), ec);
+    return ec || image.empty() ? std::filesystem::absolute(filename).string() : image.string();
+}
+
+bool xTiled::saveTilesetImage(const std::string& filename, const std::string& directory, TilesetImage& tileset) {
+    if (_tilesetFixed) {
+        tileset.image = relativeImagePath(tilesetFile, directory);
+        tileset.name = std::filesystem::path(tilesetFile).stem();
+        tileset.width = _externalWidth;
+        tileset.height = _externalHeight;
+        return true;
     }
-    appendTileToTileset(tile, _tileset);
     
-    int col = _tiledImage->width / tileWidth;
-    int row = _tiledImage->height / tileHeight;
-    arr = new int[col * row];
+    ConversionStats::Scope scope(ConversionStats::TilesetAssembly);
+    ConversionStats::set(ConversionStats::UniqueTiles, _tileCount);
     
-    int i = 0;
-    int uid;
-    for (int y = 0; y < _tiledImage->height; y += tileHeight) {
-        for (int x = 0; x < _tiledImage->width; x += tileWidth) {
-            extractTileFromImage(tile, _tiledImage, x, y, tileWidth, tileHeight);
-            uid = findTileUID(_tileset, tile, this->similarityPercentage);
-            if (uid == -1) {
-                if (_tileCount < tileCount) {
-                    appendTileToTileset(tile, _tileset);
-                    uid = ++_tileCount;
-                } else {
-                    uid = 0;
+    int rows = (_tiles.capacity() + _atlasColumns - 1) / _atlasColumns;
+    TImage* atlas;
+    {
+        Trace::Span span("createAtlas");
+        atlas = _tiles.createAtlas(_atlasColumns, rows, _tilesetMargin, _tilesetSpacing);
+    }
+    if (atlas == nullptr)
+        return false;
+    
+    {
+        ConversionStats::Scope encode(ConversionStats::PNGEncode);
+        if (indexedColour) {
+            saveImageAsPNGFile(atlas, _palette.colours(), filename);
+        } else {
+            saveImageAsPNGFile(atlas, filename);
+        }
+    }
+    tileset.image = relativeImagePath(filename, directory);
+    tileset.name = std::filesystem::path(filename).stem();
+    tileset.width = atlas->width;
+    tileset.height = atlas->height;
+    reset(atlas);
+    
+    // The index file describes tilesets laid out by xtiled, an external layout can not be restored from it.
+    if (!indexFile.empty() && !_externalTileset) {
+        saveTileIndex(filename);
+    }
+    return true;
+}
+
+bool xTiled::writeTMJFile(const std::string& tmjfile, const TileMap& map, const TilesetImage& tileset, unsigned threads) const {
+    Trace::Span span("writeTMJFile", tmjfile);
+    
+    // The document is written field by field, in the same layout Tiled uses, straight to the file.
+    FileWriter tmj;
+    if (!tmj.open(tmjfile)) {
+        std::cerr << "Error: Unable to open file for writing: " << tmjfile << std::endl;
+        return false;
+    }
+    
+    bool infinite = chunkSize > 0;
+    
+    tmj << "{ \n"
+        << "    \"compressionlevel\":-1,\n"
+        << "    \"height\":" << map.rows << ",\n"
+        << "    \"infinite\":" << (infinite ? "true" : "false") << ",\n"
+        << "    \"layers\":[\n"
+        << "        {\n";
+    
+    bool encoded;
+    if (infinite) {
+        encoded = writeLayerChunks(tmj, map.gids.data(), map.columns, map.rows, chunkSize, layerEncoding, threads, "            ");
+    } else {
+        encoded = writeLayerData(tmj, map.gids.data(), map.columns, map.rows, layerEncoding, "            ");
+    }
+    if (!encoded) {
+        std::cerr << "Error: Unable to encode the tile layer data." << std::endl;
+    }
+    
+    tmj << "            \"height\":" << map.rows << ",\n"
+        << "            \"id\":1,\n"
+        << "            \"name\":\"Tile Layer\",\n"
+        << "            \"opacity\":1,\n";
+    if (infinite) {
+        tmj << "            \"startx\":0,\n"
+            << "            \"starty\":0,\n";
+    }
+    tmj << "            \"type\":\"tilelayer\",\n"
+        << "            \"visible\":true,\n"
+        << "            \"width\":" << map.columns << ",\n"
+        << "            \"x\":0,\n"
+        << "            \"y\":0\n"
+        << "        }\n"
+        << "    ],\n"
+        << "    \"nextlayerid\":2,\n"
+        << "    \"nextobjectid\":1,\n"
+        << "    \"orientation\":\"orthogonal\",\n"
+        << "    \"renderorder\":\"right-down\",\n"
+        << "    \"tiledversion\":\"1.11.0\",\n"
+        << "    \"tileheight\":" << tileHeight << ",\n"
+        << "    \"tilesets\":[\n"
+        << "        {\n"
+        << "            \"columns\":" << _atlasColumns << ",\n"
+        << "            \"firstgid\":1,\n"
+        << "            \"image\":\"" << tileset.image << "\",\n"
+        << "            \"imageheight\":" << tileset.height << ",\n"
+        << "            \"imagewidth\":" << tileset.width << ",\n"
+        << "            \"margin\":" << _tilesetMargin << ",\n"
+        << "            \"name\":\"" << tileset.name << "\",\n"
+        << "            \"spacing\":" << _tilesetSpacing << ",\n"
+        << "            \"tilecount\":" << tileCount << ",\n"
+        << "            \"tileheight\":" << tileHeight << ",\n"
+        << "            \"tilewidth\":" << tileWidth;
+    if (transparentColor) {
+        char color[8];
+        snprintf(color, sizeof(color), "#%06x", transparentColor & 0xFFFFFF);
+        tmj << ",\n"
+            << "            \"transparentcolor\":\"" << color << "\"";
+    }
+    tmj << "\n"
+        << "        }\n"
+        << "    ],\n"
+        << "    \"tilewidth\":" << tileWidth << ",\n"
+        << "    \"type\":\"map\",\n"
+        << "    \"version\":\"1.10\",\n"
+        << "    \"width\":" << map.columns << "\n"
+        << "}";
+    
+    if (!tmj.close()) {
+        std::cerr << "Error: Failed to write file: " << tmjfile << std::endl;
+        return false;
+    }
+    
+    return encoded;
+}
+
+void xTiled::matchCells(TileMap& map, const TImage* image, int firstRow, int rowCount, const uint8_t* dirty) {
+    ConversionStats::Scope scope(ConversionStats::Matching);
+    Trace::Span span("matchCells", firstRow, firstRow + rowCount);
+    bool exact = similarityPercentage >= 1.0;
+    int cellCount = map.columns * rowCount;
+    size_t tileBytes = (size_t)tileWidth * tileHeight * (_tiles.bitWidth() / 8);
+    
+    // Classify and hash every cell in parallel bands, the results are then consumed in raster order
+    // below so that GIDs are assigned exactly as they would be by a single thread. Transparent cells
+    // and cells of a single colour are not hashed, a solid cell keeps its colour in place of a hash.
+    enum : uint8_t { General, Transparent, Solid };
+    std::vector<uint64_t> hashes(cellCount);
+    std::vector<uint8_t> kinds(cellCount, General);
+    parallelForBands(cellCount, threadCount(), [&](int begin, int end) {
+        std::vector<uint8_t> buffer(tileBytes);
+        for (int i = begin; i < end; i++) {
+            if (dirty && !dirty[i]) continue;
+            
+            TImageView view = makeImageView(image, i % map.columns * tileWidth, i / map.columns * tileHeight, tileWidth, tileHeight);
+            uint32_t colour;
+            if (isImageViewTransparent(view)) {
+                kinds[i] = Transparent;
+            } else if (isImageViewUniform(view, colour)) {
+                // Every transparent colour has the same index, so a transparent indexed cell is uniform.
+                bool transparent = indexedColour && (_palette.colour(colour) >> 24) == 0;
+                kinds[i] = transparent ? Transparent : Solid;
+                hashes[i] = colour;
+            } else {
+                hashes[i] = tileKey(view, buffer.data());
+            }
+        }
+    });
+    
+    // For similarity matching, cells identical to an earlier cell reuse its GID. Slots are only ever
+    // appended, so the first matching slot found for the earlier cell is still the first one now.
+    // This needs the earlier cells, so it is only done when the image holds every row.
+    bool memo = !exact && firstRow == 0 && rowCount == map.rows;
+    std::unordered_multimap<uint64_t, int> seen;
+    
+    Trace::Span merge("assignGIDs", firstRow, firstRow + rowCount);
+    std::vector<uint8_t> buffer(tileBytes);
+    uint32_t* gids = map.gids.data() + (size_t)firstRow * map.columns;
+    for (int i = 0; i < cellCount; i++) {
+        if (dirty && !dirty[i]) continue;
+        ConversionStats::add(ConversionStats::TilesScanned, 1);
+        
+        // A fully transparent cell is left empty rather than given a tile.
+        if (kinds[i] == Transparent) {
+            gids[i] = 0;
+            continue;
+        }
+        
+        TImageView view = makeImageView(image, i % map.columns * tileWidth, i / map.columns * tileHeight, tileWidth, tileHeight);
+        uint64_t hash = hashes[i];
+        
+        // A cell identical to a tile in the tileset always matches that tile first, even for
+        // similarity matching, as no earlier tile matched it when it was appended. Every solid tile
+        // is in _solidTiles, so a solid cell that is not there has no identical tile.
+        int64_t gid = -1;
+        uint32_t colour = 0;
+        if (kinds[i] == Solid) {
+            colour = (uint32_t)hash;
+            auto it = _solidTiles.find(colour);
+            if (it != _solidTiles.end()) {
+                gids[i] = it->second;
+                continue;
+            }
+            hash = tileKey(view, buffer.data());
+        } else {
+            gid = findTile(view, hash, buffer.data());
+        }
+        
+        if (gid == -1 && memo) {
+            auto range = seen.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                bool equal = _tiles.kernels().equal(makeImageView(image, it->second % map.columns * tileWidth, it->second / map.columns * tileHeight, tileWidth, tileHeight), view);
+                countHashCompare(view, equal);
+                if (equal) {
+                    gid = gids[it->second];
+                    break;
                 }
             }
-            arr[i++] = uid;
+            if (gid == -1) {
+                seen.emplace(hash, i);
+            }
+        }
+        
+        if (gid == -1 && !exact) {
+            gid = findSimilarTile(view, buffer.data());
+        }
+        
+        if (gid == -1) {
+            int uid = appendTileToTileset(view);
+            if (uid) {
+                _tileIndex.emplace(hash, uid);
+                if (kinds[i] == Solid) _solidTiles.emplace(colour, uid);
+                if (!exact) _similarityIndex.add(_tiles.view(uid - 1));
+            } else if (!_tilesetFixed && !_tilesetFullWarned) {
+                std::cerr << "Warning: The tileset is full, cells whose tile is not in it are left empty. Use -c to allow more tiles." << std::endl;
+                _tilesetFullWarned = true;
+            }
+            gid = uid;
         }
+        gids[i] = (uint32_t)gid;
     }
+}
+
+bool xTiled::createTileset(int bitWidth) {
+    int columnCount = (int)ceil(sqrt((double)tileCount));
+    _atlasColumns = columnCount;
+    _tilesetMargin = 0;
+    _tilesetSpacing = 0;
+    _externalTileset = false;
+    _tilesetFixed = false;
+    _tilesetFullWarned = false;
     
+    _tileCount = 0;
+    _tileIndex.clear();
+    _tileIndex.reserve(tileCount);
+    _similarityIndex.clear();
+    
+    if (!_tiles.create(tileWidth, tileHeight, bitWidth, columnCount * columnCount)) {
+        return false;
+    }
+    
+    TImage* tile = createPixmap(tileWidth, tileHeight, bitWidth);
+    
+    if (bitWidth == 8) {
+        // The slots no tile is in are index 0, which is kept transparent as it is in an RGBA tileset.
+        if (_palette.size() == 0) _palette.indexOf(0);
+        int black = _palette.indexOf(0xFF000000);
+        if (black < 0) {
+            std::cerr << "Error: The palette has no room for black." << std::endl;
+            reset(tile);
+            return false;
+        }
+        memset(tile->data, black, (size_t)tile->width * tile->height);
+    } else {
+        uint32_t* p = (uint32_t *)tile->data;
+        for (size_t i = 0; i < (size_t)tile->width * tile->height; i++) {
+            *p++ = 0xFF000000;
+        }
+    }
+    TImageView view = makeImageView(tile, 0, 0, tileWidth, tileHeight);
+    appendTileToTileset(view);
+    _tileIndex.emplace(tileKey(_tiles.view(0), tile->data), 1);
+    _solidTiles.clear();
+    uint32_t colour;
+    if (isImageViewUniform(_tiles.view(0), colour)) {
+        _solidTiles.emplace(colour, 1);
+    }
+    if (similarityPercentage < 1.0) {
+        _similarityIndex.add(_tiles.view(0));
+    }
     reset(tile);
+    
+    return true;
+}
+
+bool xTiled::loadTileIndex(int bitWidth) {
+    if (!std::filesystem::exists(indexFile))
+        return false;
+    
+    TTileIndexFile index;
+    if (!readTileIndexFile(indexFile, index)) {
+        std::cerr << "Warning: Ignoring unreadable tile index file: " << indexFile << std::endl;
+        return false;
+    }
+    if (index.tileWidth != tileWidth || index.tileHeight != tileHeight || index.tileCount != tileCount || index.bitWidth != bitWidth) {
+        std::cerr << "Warning: Ignoring tile index file built with different settings: " << indexFile << std::endl;
+        return false;
+    }
+    
+    TImage* atlas = loadImage(index.tilesetFile);
+    if (atlas == nullptr) {
+        std::cerr << "Warning: Ignoring tile index file, the tileset failed to load: " << index.tilesetFile << std::endl;
+        return false;
+    }
+    
+    if (!createTileset(bitWidth)) {
+        reset(atlas);
+        return false;
+    }
+    
+    // Every tile is hashed again, so an index whose tileset has since been edited is never used.
+    bool valid = !index.hashes.empty() && index.hashes[0] == hashImageView(_tiles.view(0)) &&
+        restoreTiles(atlas, 1, (int)index.hashes.size(), index.hashes.data());
+    reset(atlas);
+    
+    if (!valid) {
+        std::cerr << "Warning: Ignoring tile index file, the tileset no longer matches it: " << index.tilesetFile << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+bool xTiled::restoreTiles(const TImage* atlas, int first, int count, const uint64_t* hashes) {
+    if (count > (int)tileCount || atlas->bitWidth != _tiles.bitWidth())
+        return false;
+    
+    // Slots are appended in order, which gives each tile back its GID.
+    std::vector<uint8_t> buffer((size_t)tileWidth * tileHeight * (atlas->bitWidth / 8));
+    for (int slot = first; slot < count; slot++) {
+        if (_tilesetMargin + slot % _atlasColumns * (tileWidth + _tilesetSpacing) + tileWidth > atlas->width ||
+            _tilesetMargin + slot / _atlasColumns * (tileHeight + _tilesetSpacing) + tileHeight > atlas->height)
+            return false;
+        
+        TImageView view = atlasTileView(atlas, slot);
+        uint64_t hash = _tiles.kernels().hash(view);
+        if (hashes && hash != hashes[slot])
+            return false;
+        
+        int uid = appendTileToTileset(view);
+        if (uid == 0)
+            return false;
+        
+        // A tileset not built by xtiled may hold the same tile more than once, only the first is matched.
+        uint64_t key = tileKey(view, buffer.data());
+        if (findTile(_tiles.view(uid - 1), key, buffer.data()) == -1) {
+            _tileIndex.emplace(key, uid);
+            
+            uint32_t colour;
+            if (isImageViewUniform(view, colour)) {
+                _solidTiles.emplace(colour, uid);
+            }
+        }
+        if (similarityPercentage < 1.0) {
+            _similarityIndex.add(_tiles.view(uid - 1));
+        }
+    }
+    
+    return true;
+}
+
+int xTiled::usedSlotCount(const TImage* atlas, int count) const {
+    for (int slot = count - 1; slot >= 0; slot--) {
+        TImageView view = atlasTileView(atlas, slot);
+        bool blank = true;
+        for (uint32_t y = 0; y < view.height && blank; y++) {
+            const uint8_t* row = view.data + y * view.stride;
+            blank = std::all_of(row, row + view.width * (view.bitWidth / 8), [](uint8_t byte) { return byte == 0; });
+        }
+        if (!blank)
+            return slot + 1;
+    }
+    return 0;
+}
+
+bool xTiled::loadExternalTileset(int bitWidth) {
+    TImage* atlas = loadImage(tilesetFile);
+    if (atlas == nullptr) {
+        std::cerr << "Error: File '" << tilesetFile << "' failed to load." << std::endl;
+        return false;
+    }
+    
+    int columns = 0, rows = 0;
+    if (atlas->width >= tilesetMargin * 2 + tileWidth && atlas->height >= tilesetMargin * 2 + tileHeight) {
+        columns = (atlas->width - tilesetMargin * 2 + tilesetSpacing) / (tileWidth + tilesetSpacing);
+        rows = (atlas->height - tilesetMargin * 2 + tilesetSpacing) / (tileHeight + tilesetSpacing);
+    }
+    if (columns == 0 || rows == 0 || atlas->bitWidth != bitWidth) {
+        std::cerr << "Error: File '" << tilesetFile << "' does not hold tiles of the given size." << std::endl;
+        reset(atlas);
+        return false;
+    }
+    
+    _atlasColumns = columns;
+    _tilesetMargin = tilesetMargin;
+    _tilesetSpacing = tilesetSpacing;
+    
+    // Appended tiles continue the tileset's own layout, a row at a time, taking the place of the blank
+    // slots at its end. There is always room for the tile count given to be appended.
+    int count = columns * rows;
+    if (appendUnknownTiles) {
+        count = usedSlotCount(atlas, count);
+        tileCount = (count + tileCount + columns - 1) / columns * columns;
+    } else {
+        tileCount = count;
+    }
+    
+    _tileCount = 0;
+    _tileIndex.clear();
+    _tileIndex.reserve(tileCount);
+    _solidTiles.clear();
+    _similarityIndex.clear();
+    _externalTileset = false;
+    _tilesetFixed = false;
+    _tilesetFullWarned = false;
+    
+    bool success = _tiles.create(tileWidth, tileHeight, bitWidth, tileCount) && restoreTiles(atlas, 0, count, nullptr);
+    _externalWidth = atlas->width;
+    _externalHeight = atlas->height;
+    reset(atlas);
+    if (!success) {
+        std::cerr << "Error: Unable to load the tileset: " << tilesetFile << std::endl;
+        return false;
+    }
+    
+    _externalTileset = true;
+    _tilesetFixed = !appendUnknownTiles;
+    return true;
+}
+
+void xTiled::saveTileIndex(const std::string& tilesetFile) const {
+    TTileIndexFile index;
+    index.tileWidth = tileWidth;
+    index.tileHeight = tileHeight;
+    index.tileCount = tileCount;
+    index.bitWidth = (uint8_t)_tiles.bitWidth();
+    index.tilesetFile = std::filesystem::absolute(tilesetFile);
+    
+    // Slots are filled in order, so the UIDs in the index run from 1 to the number of tiles. The plain
+    // hash is stored rather than the index key, which depends on the orientations matched.
+    index.hashes.resize(_tileCount);
+    for (int slot = 0; slot < _tileCount; slot++) {
+        index.hashes[slot] = _tiles.kernels().hash(_tiles.view(slot));
+    }
+    
+    if (!writeTileIndexFile(indexFile, index)) {
+        std::cerr << "Error: Failed to write file: " << indexFile << std::endl;
+    }
+}
+
+bool xTiled::prepareTileset(int bitWidth) {
+    Trace::Span span("prepareTileset");
+    ConversionStats::Scope scope(ConversionStats::TilesetAssembly);
+    if (!tilesetFile.empty())
+        return loadExternalTileset(bitWidth);
+    
+    if (!indexFile.empty() && loadTileIndex(bitWidth))
+        return true;
+    
+    return createTileset(bitWidth);
+}
+
+void xTiled::createMap(TileMap& map, uint32_t width, uint32_t height) const {
+    map.columns = width / tileWidth;
+    map.rows = height / tileHeight;
+    map.gids.assign((size_t)map.columns * map.rows, 0);
+}
+
+bool xTiled::generateTMJData(void) {
+    Trace::Span span("generateTMJData");
+    int bitWidth = indexedColour ? 8 : _reader ? _reader->bitWidth : _tiledImage->bitWidth;
+    
+    if (indexedColour) _palette.clear();
+    if (!prepareTileset(bitWidth)) {
+        std::cout << "ERROR!\n";
+        return false;
+    }
+    
+    if (indexedColour) {
+        ConversionStats::Scope scope(ConversionStats::Decode);
+        seedPalette(_imageFile);
+        if (_tiledImage && !indexImage(_tiledImage)) {
+            std::cout << "ERROR!\n";
+            return false;
+        }
+    }
+    
+    if (!_reader) {
+        createMap(_map, _tiledImage->width, _tiledImage->height);
+        matchCells(_map, _tiledImage, 0, _map.rows);
+        return true;
+    }
+    
+    createMap(_map, _reader->width, _reader->height);
+    
+    // Streaming, only a single row of tiles is ever held in memory. For indexed colour the rows are
+    // read as RGBA into a separate band and converted to indices.
+    TImage* band = createPixmap(_reader->width, tileHeight, bitWidth);
+    TImage* pixels = indexedColour ? createPixmap(_reader->width, tileHeight, _reader->bitWidth) : band;
+    if (band == nullptr || pixels == nullptr) {
+        std::cout << "ERROR!\n";
+        if (pixels != band) reset(pixels);
+        reset(band);
+        return false;
+    }
+    bool success = true;
+    for (int r = 0; r < _map.rows; r++) {
+        ConversionStats::Scope scope(ConversionStats::Decode);
+        if (!readPNGGraphicRows(_reader, pixels->data, tileHeight)) {
+            std::cout << "ERROR!\n";
+            success = false;
+            break;
+        }
+        if (indexedColour && !_palette.indexPixels(pixels->data, band->data, (size_t)band->width * band->height)) {
+            std::cerr << "Error: The image uses more than " << ColourPalette::kMaxColours << " colours, indexed colour can not be used." << std::endl;
+            success = false;
+            break;
+        }
+        matchCells(_map, band, r, 1);
+    }
+    if (pixels != band) reset(pixels);
+    reset(band);
+    closePNGGraphicFile(_reader);
+    return success;
 }
 
+bool xTiled::generateTMJBatch(const std::vector<std::string>& imagefiles, const std::string& directory) {
+    Trace::Span span("generateTMJBatch");
+    int count = (int)imagefiles.size();
+    unsigned threads = threadCount();
+    std::vector<TileMap> maps(count);
+    
+    // Images are decoded a window at a time, one per thread, with the next window decoding while the
+    // current one is matched. Matching is done in the order given, so the tileset and every GID are
+    // the same whatever the number of threads.
+    auto loadWindow = [&](int first) {
+        return std::async(std::launch::async, [&imagefiles, first, count, threads]() {
+            std::vector<TImage*> images(std::min<int>(threads, count - first), nullptr);
+            parallelForBands((int)images.size(), threads, [&](int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                    images[i] = loadPNGImage(imagefiles[first + i]);
+                }
+            });
+            return images;
+        });
+    };
+    auto releaseWindow = [](std::vector<TImage*>& images) {
+        for (auto& image : images) reset(image);
+    };
+    
+    bool success = true;
+    std::future<std::vector<TImage*>> next = loadWindow(0);
+    for (int first = 0; first < count; first += threads) {
+        std::vector<TImage*> images;
+        {
+            // Only the time spent waiting for the images is charged to decoding.
+            ConversionStats::Scope scope(ConversionStats::Decode);
+            images = next.get();
+        }
+        if (first + (int)threads < count) {
+            next = loadWindow(first + threads);
+        }
+        
+        for (int i = 0; i < (int)images.size() && success; i++) {
+            const std::string& imagefile = imagefiles[first + i];
+            TImage* image = images[i];
+            if (image == nullptr) {
+                std::cerr << "Error: File '" << imagefile << "' failed to load." << std::endl;
+                success = false;
+                break;
+            }
+            
+            if (first + i == 0) {
+                if (indexedColour) _palette.clear();
+                if (!prepareTileset(indexedColour ? 8 : image->bitWidth)) {
+                    std::cerr << "Error: Unable to create the tileset." << std::endl;
+                    success = false;
+                    break;
+                }
+            }
+            
+            // Images are converted to indices here, in order, so the palette does not depend on timing.
+            if (indexedColour) {
+                ConversionStats::Scope scope(ConversionStats::Decode);
+                seedPalette(imagefile);
+                if (!indexImage(image)) {
+                    success = false;
+                    break;
+                }
+            }
 
+            if (image->bitWidth != _tiles.bitWidth()) {
+                std::cerr << "Error: File '" << imagefile << "' has a different pixel format to the tileset." << std::endl;
+                success = false;
+                break;
+            }
+            
+            createMap(maps[first + i], image->width, image->height);
+            matchCells(maps[first + i], image, 0, maps[first + i].rows);
+            reset(images[i]);
+        }
+        releaseWindow(images);
+        
+        if (!success) {
+            if (next.valid()) {
+                images = next.get();
+                releaseWindow(images);
+            }
+            return false;
+        }
+    }
+    
+    if (count == 0)
+        return true;
+    
+    TilesetImage tileset;
+    if (!saveTilesetImage(std::filesystem::path(directory) / "tileset.png", directory, tileset)) {
+        std::cerr << "Error: Unable to create the tileset image." << std::endl;
+        return false;
+    }
+    
+    // Every TMJ file only reads the finished tileset, so they are written concurrently.
+    ConversionStats::Scope scope(ConversionStats::TMJWrite);
+    std::vector<char> written(count, 0);
+    parallelForBands(count, threads, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            std::string tmjfile = std::filesystem::path(directory) / std::filesystem::path(imagefiles[i]).filename().replace_extension("tmj");
+            written[i] = writeTMJFile(tmjfile, maps[i], tileset, 1);
+        }
+    });
+    
+    for (int i = 0; i < count; i++) {
+        if (!written[i]) {
+            success = false;
+            continue;
+        }
+        std::cout << "✅ TMJ file saved successfully: " << std::filesystem::path(directory) / std::filesystem::path(imagefiles[i]).filename().replace_extension("tmj") << std::endl;
+    }
+    
+    return success;
+}
 
+bool xTiled::updateTMJData(const std::string& previousImageFile, const std::string& filename) {
+    Trace::Span span("updateTMJData");
+    if (indexedColour) {
+        std::cerr << "Error: A map can not be updated in indexed colour." << std::endl;
+        return false;
+    }
+    
+    std::string tmjfile = std::filesystem::path(filename).replace_extension("tmj");
+    TTMJFile tmj;
+    ConversionStats::Scope decode(ConversionStats::Decode);
+    if (!readTMJFile(tmjfile, tmj)) {
+        std::cerr << "Error: Unable to read the map: " << tmjfile << std::endl;
+        return false;
+    }
+    
+    // The tileset layout follows from the tile count, so it is taken from the map.
+    if (tmj.tileWidth != (int)tileWidth || tmj.tileHeight != (int)tileHeight || tmj.tileCount <= 0 ||
+        tmj.tilesetColumns != (int)ceil(sqrt((double)tmj.tileCount))) {
+        std::cerr << "Error: The map was not converted with the same tile size: " << tmjfile << std::endl;
+        return false;
+    }
+    tileCount = tmj.tileCount;
+    
+    uint32_t width = _reader ? _reader->width : _tiledImage->width;
+    uint32_t height = _reader ? _reader->height : _tiledImage->height;
+    int bitWidth = _reader ? _reader->bitWidth : _tiledImage->bitWidth;
+    
+    TPNGReader* previous = openPNGReader(previousImageFile);
+    if (previous == nullptr) {
+        std::cerr << "Error: File '" << previousImageFile << "' failed to load." << std::endl;
+        return false;
+    }
+    if (previous->width != width || previous->height != height || previous->bitWidth != bitWidth ||
+        (int)(width / tileWidth) != tmj.columns || (int)(height / tileHeight) != tmj.rows) {
+        std::cerr << "Error: The image is not the same size as the previous image and the map." << std::endl;
+        closePNGGraphicFile(previous);
+        return false;
+    }
+    
+    std::string tilesetFile = std::filesystem::path(tmjfile).parent_path() / tmj.tilesetImage;
+    TImage* atlas = loadPNGImage(tilesetFile);
+    ConversionStats::Scope assembly(ConversionStats::TilesetAssembly);
+    if (atlas == nullptr || !createTileset(bitWidth)) {
+        std::cerr << "Error: File '" << tilesetFile << "' failed to load." << std::endl;
+        reset(atlas);
+        closePNGGraphicFile(previous);
+        return false;
+    }
+    
+    // Every tile the map uses is restored, along with any tile after them in the atlas that is not
+    // blank, as another map may share the tileset. GID g is in slot g - 1, so the highest GID is the
+    // number of slots to restore.
+    int count = 1;
+    for (uint32_t gid : tmj.gids) {
+        count = std::max(count, (int)(gid & kGIDMask));
+    }
+    count = std::max(count, usedSlotCount(atlas, std::min((int)tileCount, (int)(atlas->width / tileWidth) * (int)(atlas->height / tileHeight))));
+    
+    bool restored = restoreTiles(atlas, 1, count, nullptr);
+    reset(atlas);
+    if (!restored) {
+        std::cerr << "Error: The map's tileset does not hold the tiles the map uses: " << tilesetFile << std::endl;
+        closePNGGraphicFile(previous);
+        return false;
+    }
+    _mapTilesetFile = tilesetFile;
+    
+    createMap(_map, width, height);
+    _map.gids = std::move(tmj.gids);
+    
+    // Both images are read a row of tiles at a time and only the cells whose pixels differ are matched.
+    TImage* previousBand = createPixmap(width, tileHeight, bitWidth);
+    TImage* currentBand = _reader ? createPixmap(width, tileHeight, bitWidth) : nullptr;
+    if (previousBand == nullptr || (_reader && currentBand == nullptr)) {
+        std::cout << "ERROR!\n";
+        reset(previousBand);
+        reset(currentBand);
+        closePNGGraphicFile(previous);
+        return false;
+    }
+    
+    bool success = true;
+    size_t changed = 0;
+    std::vector<uint8_t> dirty(_map.columns);
+    for (int r = 0; r < _map.rows; r++) {
+        ConversionStats::Scope scope(ConversionStats::Decode);
+        if (!readPNGGraphicRows(previous, previousBand->data, tileHeight) ||
+            (_reader && !readPNGGraphicRows(_reader, currentBand->data, tileHeight))) {
+            std::cout << "ERROR!\n";
+            success = false;
+            break;
+        }
+        
+        // The band of a whole image is the image's own rows, so nothing is copied.
+        TImage band = {width, tileHeight, (uint8_t)bitWidth, _reader ? currentBand->data : _tiledImage->data + (size_t)r * tileHeight * width * (bitWidth / 8)};
+        
+        ConversionStats::Scope matching(ConversionStats::Matching);
+        ConversionStats::add(ConversionStats::CompareCalls, _map.columns);
+        ConversionStats::add(ConversionStats::BytesCompared, (uint64_t)width * tileHeight * (bitWidth / 8));
+        parallelForBands(_map.columns, threadCount(), [&](int begin, int end) {
+            for (int c = begin; c < end; c++) {
+                dirty[c] = !_tiles.kernels().equal(makeImageView(previousBand, c * tileWidth, 0, tileWidth, tileHeight),
+                                                   makeImageView(&band, c * tileWidth, 0, tileWidth, tileHeight));
+            }
+        });
+        
+        size_t dirtyCount = std::count(dirty.begin(), dirty.end(), 1);
+        if (dirtyCount) {
+            matchCells(_map, &band, r, 1, dirty.data());
+            changed += dirtyCount;
+        }
+    }
+    reset(previousBand);
+    reset(currentBand);
+    closePNGGraphicFile(previous);
+    closePNGGraphicFile(_reader);
+    
+    std::cout << changed << " of " << (size_t)_map.columns * _map.rows << " cells changed.\n";
+    return success;
+}
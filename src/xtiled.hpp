@@ -25,6 +25,28 @@
 #define xtiled_hpp
 
 #include "image.hpp"
+#include "palette.hpp"
+#include "tileindex.hpp"
+#include "tilestore.hpp"
+#include <unordered_map>
+#include <thread>
+#include <string>
+#include <vector>
+
+/// How the tile layer data is stored in the TMJ file.
+enum class LayerEncoding {
+    CSV,        // A plain array of GIDs
+    Base64,     // Little-endian 32-bit GIDs, base64 encoded
+    Zlib,       // As Base64, compressed with zlib before encoding
+    Gzip,       // As Base64, compressed with gzip before encoding
+    Zstd        // As Base64, compressed with Zstandard before encoding
+};
+
+/// Flags that Tiled keeps in the top bits of a GID to flip the tile.
+constexpr uint32_t kFlippedHorizontallyFlag = 0x80000000;
+constexpr uint32_t kFlippedVerticallyFlag = 0x40000000;
+constexpr uint32_t kFlippedDiagonallyFlag = 0x20000000;
+constexpr uint32_t kGIDMask = 0x0FFFFFFF;  // Clears every flag, including Tiled's hexagonal rotation flag
 
 class xTiled {
 public:
@@ -33,27 +55,265 @@ public:
     unsigned tileCount = 2048;
     float similarityPercentage = 1.0;
     uint32_t transparentColor = 0;
+    unsigned threads = 0;   // Number of worker threads, 0 uses one per hardware thread.
+    bool streaming = false; // Decode the image a row of tiles at a time rather than loading it whole.
+    LayerEncoding layerEncoding = LayerEncoding::CSV;
+    unsigned chunkSize = 0; // Write an infinite map in chunks of chunkSize x chunkSize tiles, 0 writes a fixed size map.
+    std::string indexFile;  // Tile index cache, the tileset it names is reused if it exists and it is saved with the tileset.
+    std::string tilesetFile;        // An existing tileset to match against, its tiles keep their place and GID.
+    unsigned tilesetMargin = 0;     // Pixels around the edge of tilesetFile.
+    unsigned tilesetSpacing = 0;    // Pixels between the tiles of tilesetFile.
+    bool appendUnknownTiles = true; // Tiles not in tilesetFile are added to a copy of it, otherwise their cells are left empty.
+    bool matchFlips = false;        // Match tiles that are flipped or rotated copies of a tile, using Tiled's flip flags.
+    bool indexedColour = false;     // Work on 8-bit palette indices rather than RGBA, for images of up to 256 colours.
+    
+    /**
+     @brief    Returns true if this build is able to write tile layer data with the given encoding.
+     */
+    static bool isLayerEncodingSupported(LayerEncoding encoding);
     
     ~xTiled() {
         reset(_tiledImage);
-        reset(_tileset);
+        closePNGGraphicFile(_reader);
     }
     
     bool isTiledImageLoaded(void) {
-        return _tiledImage != nullptr;
+        return _tiledImage != nullptr || _reader != nullptr;
     }
     
-    void loadTiledImage(std::string& imagefile) {
-        _tiledImage = loadPNGGraphicFile(imagefile);
-    }
+    void loadTiledImage(std::string& imagefile);
+    
+    /**
+     @brief    Saves the tileset image and the TMJ file of the map.
+     @param    filename The file the TMJ and tileset files are named after.
+     @return   true on success.
+     */
+    bool createTMJFile(std::string& filename);
     
-    void createTMJFile(std::string& filename);
-    void generateTMJData(void);
+    /**
+     @brief    Converts the loaded image to a map, building the tileset as tiles are found.
+     @return   false if the image could not be read or converted, nothing should then be saved.
+     */
+    bool generateTMJData(void);
+    
+    /**
+     @brief    Builds a single tileset shared by all of the images, saved as tileset.png in the given
+               directory, along with a TMJ file for each image that references it.
+     @param    imagefiles The images, tiles are added to the tileset in the order given.
+     @param    directory The directory the tileset and TMJ files are written to.
+     @return   true on success.
+     */
+    bool generateTMJBatch(const std::vector<std::string>& imagefiles, const std::string& directory);
+    
+    /**
+     @brief    Converts the loaded image against the map previously converted from an earlier version of
+               it. Cells that are unchanged keep their GID and only the cells that differ are matched,
+               new tiles being appended to the map's existing tileset. Call createTMJFile afterwards to
+               save the map, the tileset is saved to the image the map already refers to.
+     @param    previousImageFile The image the map was last converted from.
+     @param    filename The map, its TMJ file and the tileset it uses are read.
+     @return   true on success.
+     */
+    bool updateTMJData(const std::string& previousImageFile, const std::string& filename);
     
 private:
+    /// The tileset image a TMJ file refers to.
+    struct TilesetImage {
+        std::string image;  // Path relative to the TMJ file
+        std::string name;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+    
+    /// The GID of every cell of a map, row by row.
+    struct TileMap {
+        int columns = 0;
+        int rows = 0;
+        std::vector<uint32_t> gids;
+    };
+    
+    unsigned threadCount(void) const {
+        if (threads) return threads;
+        unsigned count = std::thread::hardware_concurrency();
+        return count ? count : 1;
+    }
+    
+    /**
+     @brief    Returns the number of orientations a tile is matched in, the diagonal flip is only possible
+               for square tiles. Orientation bits 0, 1 and 2 are the horizontal, vertical and diagonal flips.
+     */
+    int orientationCount(void) const {
+        if (!matchFlips) return 1;
+        return tileWidth == tileHeight ? 8 : 4;
+    }
+    
+    /**
+     @brief    Returns the key of a tile in the hash index. With matchFlips it is the lowest hash of the
+               tile in any orientation, so every flipped copy of a tile has the same key.
+     @param    tile The tile.
+     @param    buffer Scratch space for one tile.
+     */
+    uint64_t tileKey(const TImageView& tile, uint8_t* buffer) const;
+    
+    /**
+     @brief    Finds a tile in the tileset identical to the given tile, in any orientation matched.
+     @param    tile The tile to be found.
+     @param    key The key of the tile.
+     @param    buffer Scratch space for one tile.
+     @return   The GID, with any flip flags, or -1 if not found.
+     */
+    int64_t findTile(const TImageView& tile, uint64_t key, uint8_t* buffer) const;
+    
+    /**
+     @brief    Finds the first tile in the tileset similar enough to the given tile, trying each orientation in turn.
+     @return   The GID, with any flip flags, or -1 if not found.
+     */
+    int64_t findSimilarTile(const TImageView& tile, uint8_t* buffer) const;
+    
+    /**
+     @brief    Loads a PNG, converted to palette indices when indexedColour is set.
+     @return   The image, or nullptr if it failed to load or has too many colours.
+     */
+    TImage* loadImage(const std::string& filename);
+    
+    /**
+     @brief    Converts a 32-bit RGBA image to 8-bit indices into the palette, in place.
+     @return   false if the palette can not hold every colour of the image.
+     */
+    bool indexImage(TImage* image);
+    
+    /**
+     @brief    Adds the colours of an indexed colour PNG to the palette in its own order, so they keep
+               their indices when nothing earlier is using them.
+     */
+    void seedPalette(const std::string& filename);
+    
+    /**
+     @brief    Copies a tile into the next free slot of the tileset.
+     @param    tile The tile to be appended.
+     @return   The UID of the new tile, or 0 if the tileset is full.
+     */
+    int appendTileToTileset(const TImageView& tile);
+    
+    /**
+     @brief    Creates an empty tileset holding only the opaque black tile, UID 1.
+     @return   true on success.
+     */
+    bool createTileset(int bitWidth);
+    
+    /**
+     @brief    Creates the tileset from the tiles of tilesetFile, each tile's GID being its place in the image.
+     @return   true on success.
+     */
+    bool loadExternalTileset(int bitWidth);
+    
+    /**
+     @brief    Returns a view of the tile in the given slot of a tileset image.
+     */
+    TImageView atlasTileView(const TImage* atlas, int slot) const {
+        return makeImageView(atlas, _tilesetMargin + slot % _atlasColumns * (tileWidth + _tilesetSpacing),
+                             _tilesetMargin + slot / _atlasColumns * (tileHeight + _tilesetSpacing), tileWidth, tileHeight);
+    }
+    
+    /**
+     @brief    Returns the number of slots of a tileset image up to and including the last slot that is not blank.
+     @param    count The number of slots of the image to look at.
+     */
+    int usedSlotCount(const TImage* atlas, int count) const;
+    
+    /**
+     @brief    Restores the tileset saved along with the tile index file, so the tiles keep their GIDs.
+     @return   true if the tileset was restored, otherwise the tileset must be created afresh.
+     */
+    bool loadTileIndex(int bitWidth);
+    
+    /**
+     @brief    Appends the tiles in slots first to count - 1 of a tileset image to a tileset holding the
+               tiles of the slots before first, so each tile is given back its GID.
+     @param    atlas The tileset image.
+     @param    first The first slot to restore.
+     @param    count The number of slots in the tileset once restored.
+     @param    hashes The expected hash of the tile in each slot, nullptr to skip checking.
+     @return   false if the image is too small or a tile does not have the expected hash.
+     */
+    bool restoreTiles(const TImage* atlas, int first, int count, const uint64_t* hashes);
+    
+    /**
+     @brief    Saves the tile index file for the tileset image that has just been saved.
+     */
+    void saveTileIndex(const std::string& tilesetFile) const;
+    
+    /**
+     @brief    Restores the tileset from the tile index file when there is one, otherwise creates it.
+     @return   true on success.
+     */
+    bool prepareTileset(int bitWidth);
+    
+    /**
+     @brief    Sizes a map to the number of whole tiles that fit in an image, every cell starts as 0.
+     */
+    void createMap(TileMap& map, uint32_t width, uint32_t height) const;
+    
+    /**
+     @brief    Assigns a UID to each cell in a band of rows of tiles, appending new tiles to the tileset.
+     @param    map The map the band belongs to.
+     @param    image The image holding the band, its top row is the top row of the band.
+     @param    firstRow The row of tiles in the map that the band starts at.
+     @param    rowCount The number of rows of tiles in the band.
+     @param    dirty When given, only the cells of the band it flags are matched, the rest are left as they are.
+     */
+    void matchCells(TileMap& map, const TImage* image, int firstRow, int rowCount, const uint8_t* dirty = nullptr);
+    
+    /**
+     @brief    Saves the tileset image, or when the tileset is an unchanged external tileset refers to it.
+     @param    filename The file for the tileset image.
+     @param    directory The directory of the TMJ files that will use the tileset.
+     @param    tileset The tileset image for the TMJ files.
+     @return   true on success.
+     */
+    bool saveTilesetImage(const std::string& filename, const std::string& directory, TilesetImage& tileset);
+    
+    /**
+     @brief    Writes the TMJ file for a map that uses the tileset image given.
+     @param    threads The number of threads used to encode the layer data.
+     @return   true on success.
+     */
+    bool writeTMJFile(const std::string& tmjfile, const TileMap& map, const TilesetImage& tileset, unsigned threads) const;
+    
     TImage* _tiledImage = nullptr;
-    TImage* _tileset = nullptr;
+    TPNGReader* _reader = nullptr;
+    TileMap _map;
+    TileStore _tiles;
+    int _atlasColumns = 0;
+    int _tilesetMargin = 0;
+    int _tilesetSpacing = 0;
     int _tileCount = 0;
+    
+    // The tileset came from tilesetFile, and when appendUnknownTiles is false no tile may be added to it
+    bool _externalTileset = false;
+    bool _tilesetFixed = false;
+    uint32_t _externalWidth = 0;
+    uint32_t _externalHeight = 0;
+    
+    // A tile has not fitted in the tileset and the cells left empty have been reported
+    bool _tilesetFullWarned = false;
+    
+    // The tileset image of the map being updated, the tileset is saved back to it
+    std::string _mapTilesetFile;
+    
+    // Tile content hash to UID, used for exact matching when similarityPercentage is 1.0
+    std::unordered_multimap<uint64_t, int> _tileIndex;
+    
+    // The colours of the images when indexedColour is set, and the image whose colours are added once
+    // the tileset is ready
+    ColourPalette _palette;
+    std::string _imageFile;
+    
+    // Colour to UID of the tiles that are a single colour, so solid cells are matched without hashing
+    std::unordered_map<uint32_t, int> _solidTiles;
+    
+    // Pivot index used for matching when similarityPercentage is below 1.0
+    TileSimilarityIndex _similarityIndex;
 };
 
 #endif /* xtiled_hpp */
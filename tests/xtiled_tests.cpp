@@ -0,0 +1,873 @@
+// The MIT License (MIT)
+// 
+// Copyright (c) 2024-2025 Insoft.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+ 
+
+/*
+ Checks of the conversion pipeline that need whole maps, run on synthetic maps written to a
+ temporary directory. Each check converts maps through xTiled and reads the TMJ and tileset files
+ back to compare them. The image kernels the pipeline is built on are checked against plain loops.
+ 
+ Usage: xtiled_tests [--filter <text>]
+ */
+
+#include "image.hpp"
+#include "mapgenerator.hpp"
+#include "tmjfile.hpp"
+#include "xtiled.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <png.h>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return false; \
+    } \
+} while (0)
+
+static std::filesystem::path directory;
+
+static std::string path(const std::string& filename) {
+    return (directory / filename).string();
+}
+
+//MARK: - Helpers
+
+static TMapGeneratorOptions mapOptions(uint32_t columns, uint32_t rows, uint32_t uniqueTiles) {
+    TMapGeneratorOptions options;
+    options.columns = columns;
+    options.rows = rows;
+    options.uniqueTiles = uniqueTiles;
+    return options;
+}
+
+static bool saveMap(const TMapGeneratorOptions& options, const std::string& filename, const std::function<void(TImage*)>& edit = nullptr) {
+    TImage* image = generateMapImage(options);
+    if (image == nullptr)
+        return false;
+    if (edit) edit(image);
+    bool success = saveImageAsPNGFile(image, filename);
+    reset(image);
+    return success;
+}
+
+/*
+ Inverts the colour of a block of pixels, the pixels keep their alpha.
+ */
+static void invertBlock(TImage* image, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    for (uint32_t r = y; r < y + height; r++) {
+        uint8_t* p = image->data + ((size_t)r * image->width + x) * 4;
+        for (uint32_t i = 0; i < width * 4; i++) {
+            if (i % 4 != 3) p[i] ^= 0xFF;
+        }
+    }
+}
+
+/*
+ Creates a pixmap of random bytes, the same seed always giving the same pixmap.
+ */
+static TImage* randomImage(uint32_t width, uint32_t height, int bitWidth, uint32_t seed) {
+    TImage* image = createPixmap(width, height, bitWidth);
+    if (image == nullptr)
+        return nullptr;
+    std::mt19937 random(seed);
+    for (size_t i = 0; i < (size_t)width * height * (bitWidth / 8); i++) {
+        image->data[i] = (uint8_t)random();
+    }
+    return image;
+}
+
+static TImage* copyImage(const TImage* image) {
+    TImage* copy = createPixmap(image->width, image->height, image->bitWidth);
+    if (copy == nullptr)
+        return nullptr;
+    memcpy(copy->data, image->data, (size_t)image->width * image->height * (image->bitWidth / 8));
+    return copy;
+}
+
+/*
+ Changes about one byte in every given number of a pixmap.
+ */
+static void scrambleBytes(TImage* image, uint32_t oneIn, uint32_t seed) {
+    std::mt19937 random(seed);
+    for (size_t i = 0; i < (size_t)image->width * image->height * (image->bitWidth / 8); i++) {
+        if (random() % oneIn == 0) image->data[i] ^= 0x5A;
+    }
+}
+
+/*
+ Counts the equal bytes of two views one byte at a time, the result the compare kernels must give.
+ */
+static size_t countEqualBytes(const TImageView& a, const TImageView& b) {
+    size_t count = 0;
+    for (uint32_t y = 0; y < a.height; y++) {
+        for (size_t i = 0; i < (size_t)a.width * (a.bitWidth / 8); i++) {
+            if (a.data[y * a.stride + i] == b.data[y * b.stride + i]) count++;
+        }
+    }
+    return count;
+}
+
+static void setUp(xTiled& xtiled, uint32_t tileSize) {
+    xtiled.tileWidth = tileSize;
+    xtiled.tileHeight = tileSize;
+}
+
+static bool convertMap(xTiled& xtiled, std::string imagefile, std::string filename) {
+    xtiled.loadTiledImage(imagefile);
+    return xtiled.isTiledImageLoaded() && xtiled.generateTMJData() && xtiled.createTMJFile(filename);
+}
+
+static bool updateMap(xTiled& xtiled, const std::string& previousImagefile, std::string imagefile, std::string filename) {
+    xtiled.loadTiledImage(imagefile);
+    return xtiled.isTiledImageLoaded() && xtiled.updateTMJData(previousImagefile, filename) && xtiled.createTMJFile(filename);
+}
+
+static TImage* loadImage(const std::string& filename) {
+    try {
+        return loadPNGGraphicFile(filename);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+static bool samePixel(const uint8_t* a, const uint8_t* b) {
+    // Fully transparent pixels are all the same, whatever their colour.
+    return (a[3] == 0 && b[3] == 0) || memcmp(a, b, 4) == 0;
+}
+
+static bool sameImage(const TImage* a, const TImage* b) {
+    if (a == nullptr || b == nullptr || a->width != b->width || a->height != b->height || a->bitWidth != 32 || b->bitWidth != 32)
+        return false;
+    for (size_t i = 0; i < (size_t)a->width * a->height; i++) {
+        if (!samePixel(a->data + i * 4, b->data + i * 4))
+            return false;
+    }
+    return true;
+}
+
+static std::string tilesetPath(const std::string& tmjfile, const TTMJFile& tmj) {
+    return (std::filesystem::path(tmjfile).parent_path() / tmj.tilesetImage).string();
+}
+
+/*
+ Returns true if drawing the map with its tileset gives back the image, an empty cell being fully
+ transparent. The margin and spacing are those of the tileset.
+ */
+static bool mapShowsImage(const std::string& tmjfile, const std::string& imagefile, uint32_t margin = 0, uint32_t spacing = 0) {
+    TTMJFile tmj;
+    if (!readTMJFile(tmjfile, tmj))
+        return false;
+    
+    TImage* image = loadImage(imagefile);
+    TImage* atlas = loadImage(tilesetPath(tmjfile, tmj));
+    bool same = image && atlas && image->bitWidth == 32 && atlas->bitWidth == 32 &&
+        image->width / tmj.tileWidth == (uint32_t)tmj.columns && image->height / tmj.tileHeight == (uint32_t)tmj.rows;
+    
+    for (int cell = 0; same && cell < tmj.columns * tmj.rows; cell++) {
+        uint32_t gid = tmj.gids[cell];
+        uint32_t x = cell % tmj.columns * tmj.tileWidth;
+        uint32_t y = cell / tmj.columns * tmj.tileHeight;
+        uint32_t tx = margin + (gid - 1) % tmj.tilesetColumns * (tmj.tileWidth + spacing);
+        uint32_t ty = margin + (gid - 1) / tmj.tilesetColumns * (tmj.tileHeight + spacing);
+        same = gid == 0 || (tx + tmj.tileWidth <= atlas->width && ty + tmj.tileHeight <= atlas->height);
+        
+        for (int r = 0; same && r < tmj.tileHeight; r++) {
+            for (int c = 0; same && c < tmj.tileWidth; c++) {
+                const uint8_t* pixel = image->data + ((size_t)(y + r) * image->width + x + c) * 4;
+                same = gid == 0 ? pixel[3] == 0 : samePixel(pixel, atlas->data + ((size_t)(ty + r) * atlas->width + tx + c) * 4);
+            }
+        }
+    }
+    
+    reset(image);
+    reset(atlas);
+    return same;
+}
+
+/*
+ Returns true if two maps have the same GIDs and tilesets of the same tiles.
+ */
+static bool sameMap(const std::string& tmjfileA, const std::string& tmjfileB) {
+    TTMJFile a, b;
+    if (!readTMJFile(tmjfileA, a) || !readTMJFile(tmjfileB, b))
+        return false;
+    if (a.gids != b.gids || a.tileCount != b.tileCount || a.tilesetColumns != b.tilesetColumns)
+        return false;
+    
+    TImage* atlasA = loadImage(tilesetPath(tmjfileA, a));
+    TImage* atlasB = loadImage(tilesetPath(tmjfileB, b));
+    bool same = sameImage(atlasA, atlasB);
+    reset(atlasA);
+    reset(atlasB);
+    return same;
+}
+
+/// A cell of a sparse image that holds a tile, the tile's pattern depending on the cell's place in the list.
+typedef struct {
+    uint32_t column;
+    uint32_t row;
+} TSparseCell;
+
+static bool sparsePixel(size_t cell, uint32_t x, uint32_t y) {
+    return (x * 3 + y * 5 + cell) % 7 < 3;
+}
+
+/*
+ Writes a 1-bit palette PNG a row at a time, fully transparent apart from the given cells, so an
+ image too large to be held in memory can be made.
+ */
+static bool saveSparseImage(const std::string& filename, uint32_t width, uint32_t height, uint32_t tileSize, const std::vector<TSparseCell>& cells) {
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    std::vector<uint8_t> row((width + 7) / 8);
+    if (info == nullptr || setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        fclose(file);
+        return false;
+    }
+    
+    png_init_io(png, file);
+    png_set_compression_level(png, 1);
+    png_set_IHDR(png, info, width, height, 1, PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_color palette[2] = {{0, 0, 0}, {0xFF, 0x80, 0x00}};
+    png_byte alpha[1] = {0};
+    png_set_PLTE(png, info, palette, 2);
+    png_set_tRNS(png, info, alpha, 1, nullptr);
+    png_write_info(png, info);
+    
+    for (uint32_t y = 0; y < height; y++) {
+        std::fill(row.begin(), row.end(), 0);
+        for (size_t cell = 0; cell < cells.size(); cell++) {
+            if (y / tileSize != cells[cell].row)
+                continue;
+            for (uint32_t x = cells[cell].column * tileSize; x < (cells[cell].column + 1) * tileSize; x++) {
+                if (sparsePixel(cell, x % tileSize, y % tileSize)) row[x / 8] |= 0x80 >> (x % 8);
+            }
+        }
+        png_write_row(png, row.data());
+    }
+    
+    png_write_end(png, nullptr);
+    png_destroy_write_struct(&png, &info);
+    return fclose(file) == 0;
+}
+
+//MARK: - Checks
+
+/*
+ Updating a map after part of its image has changed gives the map a full conversion of the changed
+ image would, the new tiles being appended after the tiles the map already uses.
+ */
+static bool updateMatchesConversion(uint32_t uniqueTiles) {
+    TMapGeneratorOptions options = mapOptions(200, 150, uniqueTiles);
+    CHECK(saveMap(options, path("before.png")));
+    CHECK(saveMap(options, path("after.png"), [](TImage* image) {
+        invertBlock(image, image->width - 60, image->height - 50, 40, 40);
+    }));
+    
+    xTiled converter;
+    setUp(converter, options.tileWidth);
+    CHECK(convertMap(converter, path("before.png"), path("map")));
+    
+    xTiled updater;
+    setUp(updater, options.tileWidth);
+    CHECK(updateMap(updater, path("before.png"), path("after.png"), path("map")));
+    
+    xTiled reconverter;
+    setUp(reconverter, options.tileWidth);
+    CHECK(convertMap(reconverter, path("after.png"), path("full")));
+    
+    CHECK(sameMap(path("map.tmj"), path("full.tmj")));
+    
+    // Cells whose tile did not fit in a full tileset are left empty.
+    CHECK(uniqueTiles >= updater.tileCount || mapShowsImage(path("map.tmj"), path("after.png")));
+    return true;
+}
+
+static bool updateMatchesConversion(void) {
+    return updateMatchesConversion(512);
+}
+
+/*
+ With more distinct tiles than the tileset holds every slot is used, so the map uses the highest GID.
+ */
+static bool updateMatchesConversionWithFullTileset(void) {
+    return updateMatchesConversion(3000);
+}
+
+/*
+ A map that shares the tileset of a batch is updated in place, the tileset keeps the tiles of the
+ other maps.
+ */
+static bool updateKeepsSharedTileset(void) {
+    TMapGeneratorOptions options = mapOptions(40, 30, 64);
+    CHECK(saveMap(options, path("first.png")));
+    options.seed = 2;
+    CHECK(saveMap(options, path("second.png")));
+    options.seed = 1;
+    CHECK(saveMap(options, path("first_edited.png"), [](TImage* image) {
+        invertBlock(image, 100, 100, 40, 40);
+    }));
+    
+    std::filesystem::path batch = directory / "batch";
+    std::filesystem::create_directories(batch);
+    xTiled converter;
+    setUp(converter, options.tileWidth);
+    CHECK(converter.generateTMJBatch({path("first.png"), path("second.png")}, batch.string()));
+    
+    xTiled updater;
+    setUp(updater, options.tileWidth);
+    CHECK(updateMap(updater, path("first.png"), path("first_edited.png"), (batch / "first").string()));
+    
+    TTMJFile tmj;
+    CHECK(readTMJFile((batch / "first.tmj").string(), tmj));
+    CHECK(tmj.tilesetImage == "tileset.png");
+    CHECK(!std::filesystem::exists(batch / "first.png"));
+    CHECK(mapShowsImage((batch / "first.tmj").string(), path("first_edited.png")));
+    CHECK(mapShowsImage((batch / "second.tmj").string(), path("second.png")));
+    return true;
+}
+
+/*
+ Converting against a tileset made by xtiled, whose atlas has a slot for every tile the tile count
+ allows, still leaves room to append the tiles that are not in it.
+ */
+static bool externalTilesetHasRoomToAppend(void) {
+    TMapGeneratorOptions options = mapOptions(50, 40, 64);
+    CHECK(saveMap(options, path("base.png")));
+    options.seed = 2;
+    CHECK(saveMap(options, path("other.png")));
+    
+    xTiled converter;
+    setUp(converter, options.tileWidth);
+    CHECK(convertMap(converter, path("base.png"), path("base_map")));
+    
+    xTiled matcher;
+    setUp(matcher, options.tileWidth);
+    matcher.tilesetFile = path("base_map.png");
+    CHECK(convertMap(matcher, path("other.png"), path("other_map")));
+    CHECK(mapShowsImage(path("other_map.tmj"), path("other.png")));
+    
+    // The tiles of the tileset keep their GIDs.
+    TTMJFile base, other;
+    CHECK(readTMJFile(path("base_map.tmj"), base) && readTMJFile(path("other_map.tmj"), other));
+    xTiled rematcher;
+    setUp(rematcher, options.tileWidth);
+    rematcher.tilesetFile = path("other_map.png");
+    CHECK(convertMap(rematcher, path("base.png"), path("base_again")));
+    TTMJFile again;
+    CHECK(readTMJFile(path("base_again.tmj"), again));
+    CHECK(again.gids == base.gids);
+    return true;
+}
+
+/*
+ An indexed colour map is drawn from a palette PNG, which reads back as the colours it was saved
+ from, whether it is used as the map's tileset, as an existing tileset or as the tileset of an update.
+ */
+static bool indexedMapRoundTrips(void) {
+    TMapGeneratorOptions options = mapOptions(60, 40, 32);
+    CHECK(saveMap(options, path("before.png")));
+    CHECK(saveMap(options, path("after.png"), [](TImage* image) {
+        invertBlock(image, 300, 200, 40, 40);
+    }));
+    
+    xTiled converter;
+    setUp(converter, options.tileWidth);
+    converter.indexedColour = true;
+    converter.indexFile = path("map.index");
+    CHECK(convertMap(converter, path("before.png"), path("map")));
+    
+    std::vector<uint32_t> palette;
+    CHECK(loadPNGPalette(path("map.png"), palette));
+    CHECK(mapShowsImage(path("map.tmj"), path("before.png")));
+    
+    xTiled matcher;
+    setUp(matcher, options.tileWidth);
+    matcher.tilesetFile = path("map.png");
+    matcher.appendUnknownTiles = false;
+    CHECK(convertMap(matcher, path("before.png"), path("matched")));
+    CHECK(mapShowsImage(path("matched.tmj"), path("before.png")));
+    
+    xTiled updater;
+    setUp(updater, options.tileWidth);
+    CHECK(updateMap(updater, path("before.png"), path("after.png"), path("map")));
+    CHECK(mapShowsImage(path("map.tmj"), path("after.png")));
+    return true;
+}
+
+/*
+ A conversion to indexed colour of an image with more than 256 colours fails before anything is
+ saved, read whole or streamed.
+ */
+static bool indexedConversionFailsWithTooManyColours(void) {
+    TMapGeneratorOptions options = mapOptions(20, 20, 512);
+    std::string imagefile = path("many.png");
+    CHECK(saveMap(options, imagefile));
+    
+    for (bool streaming : {false, true}) {
+        xTiled xtiled;
+        setUp(xtiled, options.tileWidth);
+        xtiled.indexedColour = true;
+        xtiled.streaming = streaming;
+        xtiled.loadTiledImage(imagefile);
+        CHECK(xtiled.isTiledImageLoaded());
+        CHECK(!xtiled.generateTMJData());
+    }
+    return true;
+}
+
+/*
+ A streamed image wider and taller than 65535 pixels is converted, its tiles found in the cells
+ past the 16-bit range.
+ */
+static bool largeSparseImageConverts(void) {
+    const uint32_t size = 70000, tileSize = 40;
+    const std::vector<TSparseCell> cells = {{0, 0}, {1749, 0}, {1700, 1650}, {0, 1749}, {1749, 1749}};
+    CHECK(saveSparseImage(path("large.png"), size, size, tileSize, cells));
+    
+    xTiled xtiled;
+    setUp(xtiled, tileSize);
+    xtiled.streaming = true;
+    CHECK(convertMap(xtiled, path("large.png"), path("large")));
+    
+    TTMJFile tmj;
+    CHECK(readTMJFile(path("large.tmj"), tmj));
+    CHECK(tmj.columns == (int)(size / tileSize) && tmj.rows == (int)(size / tileSize));
+    
+    // Every other cell is empty, and the tiles follow the black tile in the order they are found,
+    // which is the order of the cells.
+    std::vector<uint32_t> gids((size_t)tmj.columns * tmj.rows, 0);
+    for (size_t cell = 0; cell < cells.size(); cell++) {
+        gids[(size_t)cells[cell].row * tmj.columns + cells[cell].column] = (uint32_t)cell + 2;
+    }
+    CHECK(tmj.gids == gids);
+    
+    TImage* atlas = loadImage(tilesetPath(path("large.tmj"), tmj));
+    CHECK(atlas != nullptr);
+    bool same = true;
+    for (size_t cell = 0; cell < cells.size() && same; cell++) {
+        uint32_t slot = (uint32_t)cell + 1;
+        for (uint32_t y = 0; y < tileSize && same; y++) {
+            for (uint32_t x = 0; x < tileSize && same; x++) {
+                const uint8_t* pixel = atlas->data + ((size_t)(slot / tmj.tilesetColumns * tileSize + y) * atlas->width + slot % tmj.tilesetColumns * tileSize + x) * 4;
+                same = sparsePixel(cell, x, y) ? memcmp(pixel, "\xFF\x80\x00\xFF", 4) == 0 : pixel[3] == 0;
+            }
+        }
+    }
+    reset(atlas);
+    CHECK(same);
+    return true;
+}
+
+/*
+ Every layer encoding the build supports reads back as the GIDs of the CSV layer.
+ */
+static bool layerEncodingsReadBack(void) {
+    TMapGeneratorOptions options = mapOptions(30, 20, 64);
+    options.transparentRatio = 0.2f;
+    CHECK(saveMap(options, path("image.png")));
+    
+    xTiled converter;
+    setUp(converter, options.tileWidth);
+    CHECK(convertMap(converter, path("image.png"), path("csv")));
+    CHECK(mapShowsImage(path("csv.tmj"), path("image.png")));
+    TTMJFile csv;
+    CHECK(readTMJFile(path("csv.tmj"), csv));
+    
+    for (LayerEncoding encoding : {LayerEncoding::Base64, LayerEncoding::Zlib, LayerEncoding::Gzip, LayerEncoding::Zstd}) {
+        if (!xTiled::isLayerEncodingSupported(encoding))
+            continue;
+        xTiled encoder;
+        setUp(encoder, options.tileWidth);
+        encoder.layerEncoding = encoding;
+        CHECK(convertMap(encoder, path("image.png"), path("encoded")));
+        
+        TTMJFile encoded;
+        CHECK(readTMJFile(path("encoded.tmj"), encoded));
+        CHECK(encoded.columns == csv.columns && encoded.rows == csv.rows);
+        CHECK(encoded.gids == csv.gids);
+    }
+    return true;
+}
+
+/*
+ The chunks of an infinite map, the last row and column of them partly outside the image, reassemble
+ to the layer of the fixed size map in every encoding.
+ */
+static bool chunkedMapReassembles(void) {
+    TMapGeneratorOptions options = mapOptions(37, 23, 64);
+    options.transparentRatio = 0.2f;
+    CHECK(saveMap(options, path("image.png")));
+    
+    xTiled converter;
+    setUp(converter, options.tileWidth);
+    CHECK(convertMap(converter, path("image.png"), path("flat")));
+    TTMJFile flat;
+    CHECK(readTMJFile(path("flat.tmj"), flat));
+    
+    for (LayerEncoding encoding : {LayerEncoding::CSV, LayerEncoding::Base64, LayerEncoding::Zlib, LayerEncoding::Gzip, LayerEncoding::Zstd}) {
+        if (!xTiled::isLayerEncodingSupported(encoding))
+            continue;
+        xTiled chunker;
+        setUp(chunker, options.tileWidth);
+        chunker.layerEncoding = encoding;
+        chunker.chunkSize = 16;
+        CHECK(convertMap(chunker, path("image.png"), path("chunked")));
+        
+        TTMJFile chunked;
+        CHECK(readTMJFile(path("chunked.tmj"), chunked));
+        CHECK(chunked.columns == flat.columns && chunked.rows == flat.rows);
+        CHECK(chunked.gids == flat.gids);
+    }
+    return true;
+}
+
+/*
+ Maps converted with the same tile index keep the GIDs of the tiles found by earlier runs, a tile new
+ to a run being given the next GID.
+ */
+static bool indexKeepsGIDsAcrossRuns(void) {
+    TMapGeneratorOptions options = mapOptions(40, 30, 64);
+    CHECK(saveMap(options, path("first.png")));
+    CHECK(saveMap(options, path("second.png"), [](TImage* image) {
+        invertBlock(image, 96, 96, 48, 48);
+    }));
+    
+    xTiled first;
+    setUp(first, options.tileWidth);
+    first.indexFile = path("tiles.index");
+    CHECK(convertMap(first, path("first.png"), path("first_map")));
+    CHECK(std::filesystem::exists(path("tiles.index")));
+    
+    xTiled second;
+    setUp(second, options.tileWidth);
+    second.indexFile = path("tiles.index");
+    CHECK(convertMap(second, path("second.png"), path("second_map")));
+    CHECK(mapShowsImage(path("second_map.tmj"), path("second.png")));
+    
+    xTiled again;
+    setUp(again, options.tileWidth);
+    again.indexFile = path("tiles.index");
+    CHECK(convertMap(again, path("first.png"), path("first_again")));
+    
+    TTMJFile firstMap, secondMap, firstAgain;
+    CHECK(readTMJFile(path("first_map.tmj"), firstMap));
+    CHECK(readTMJFile(path("second_map.tmj"), secondMap));
+    CHECK(readTMJFile(path("first_again.tmj"), firstAgain));
+    CHECK(firstAgain.gids == firstMap.gids);
+    
+    // Only the cells of the inverted block differ, their tiles following those of the first map.
+    uint32_t highest = *std::max_element(firstMap.gids.begin(), firstMap.gids.end());
+    for (int cell = 0; cell < firstMap.columns * firstMap.rows; cell++) {
+        int column = cell % firstMap.columns, row = cell / firstMap.columns;
+        bool inverted = column >= 6 && column < 9 && row >= 6 && row < 9;
+        CHECK(inverted ? secondMap.gids[cell] > highest : secondMap.gids[cell] == firstMap.gids[cell]);
+    }
+    return true;
+}
+
+/*
+ A tileset with a margin around its tiles and spacing between them is matched against tile for tile,
+ and the tiles appended to it are placed with the same margin and spacing.
+ */
+static bool externalTilesetWithMarginAndSpacing(void) {
+    const uint32_t margin = 3, spacing = 2;
+    TMapGeneratorOptions options = mapOptions(30, 20, 48);
+    CHECK(saveMap(options, path("first.png")));
+    options.seed = 2;
+    CHECK(saveMap(options, path("second.png")));
+    
+    xTiled converter;
+    setUp(converter, options.tileWidth);
+    CHECK(convertMap(converter, path("first.png"), path("first_map")));
+    TTMJFile first;
+    CHECK(readTMJFile(path("first_map.tmj"), first));
+    
+    // The tileset of the first map, spread out with a margin and spacing.
+    TImage* packed = loadImage(path("first_map.png"));
+    CHECK(packed != nullptr);
+    uint32_t columns = packed->width / options.tileWidth, rows = packed->height / options.tileHeight;
+    TImage* spaced = createPixmap(margin * 2 + columns * (options.tileWidth + spacing) - spacing,
+                                  margin * 2 + rows * (options.tileHeight + spacing) - spacing, 32);
+    CHECK(spaced != nullptr);
+    for (uint32_t slot = 0; slot < columns * rows; slot++) {
+        copyPixmap(spaced, margin + slot % columns * (options.tileWidth + spacing), margin + slot / columns * (options.tileHeight + spacing),
+                   packed, slot % columns * options.tileWidth, slot / columns * options.tileHeight, options.tileWidth, options.tileHeight);
+    }
+    bool saved = saveImageAsPNGFile(spaced, path("spaced.png"));
+    reset(packed);
+    reset(spaced);
+    CHECK(saved);
+    
+    xTiled matcher;
+    setUp(matcher, options.tileWidth);
+    matcher.tilesetFile = path("spaced.png");
+    matcher.tilesetMargin = margin;
+    matcher.tilesetSpacing = spacing;
+    matcher.appendUnknownTiles = false;
+    CHECK(convertMap(matcher, path("first.png"), path("matched")));
+    TTMJFile matched;
+    CHECK(readTMJFile(path("matched.tmj"), matched));
+    CHECK(matched.gids == first.gids);
+    CHECK(mapShowsImage(path("matched.tmj"), path("first.png"), margin, spacing));
+    
+    xTiled appender;
+    setUp(appender, options.tileWidth);
+    appender.tilesetFile = path("spaced.png");
+    appender.tilesetMargin = margin;
+    appender.tilesetSpacing = spacing;
+    CHECK(convertMap(appender, path("second.png"), path("appended")));
+    CHECK(mapShowsImage(path("appended.tmj"), path("second.png"), margin, spacing));
+    return true;
+}
+
+/*
+ A tile drawn in each of its eight orientations is matched to the first of them, the flags of each GID
+ being the flips that Tiled applies to draw it: the diagonal flip first, then the horizontal and the
+ vertical flips.
+ */
+static bool flippedTilesGetFlipFlags(void) {
+    const uint32_t tileSize = 16;
+    TImage* tile = randomImage(tileSize, tileSize, 32, 3);
+    TImage* image = createPixmap(tileSize * 8, tileSize, 32);
+    CHECK(tile && image);
+    for (size_t i = 3; i < (size_t)tileSize * tileSize * 4; i += 4) {
+        tile->data[i] = 0xFF;
+    }
+    
+    for (uint32_t orientation = 0; orientation < 8; orientation++) {
+        for (uint32_t y = 0; y < tileSize; y++) {
+            for (uint32_t x = 0; x < tileSize; x++) {
+                uint32_t fx = orientation & 1 ? tileSize - 1 - x : x;
+                uint32_t fy = orientation & 2 ? tileSize - 1 - y : y;
+                if (orientation & 4) std::swap(fx, fy);
+                memcpy(image->data + ((size_t)y * image->width + orientation * tileSize + x) * 4, tile->data + ((size_t)fy * tileSize + fx) * 4, 4);
+            }
+        }
+    }
+    bool saved = saveImageAsPNGFile(image, path("flips.png"));
+    reset(tile);
+    reset(image);
+    CHECK(saved);
+    
+    xTiled converter;
+    setUp(converter, tileSize);
+    converter.matchFlips = true;
+    CHECK(convertMap(converter, path("flips.png"), path("flipped")));
+    
+    TTMJFile tmj;
+    CHECK(readTMJFile(path("flipped.tmj"), tmj));
+    CHECK(tmj.gids.size() == 8);
+    for (uint32_t orientation = 0; orientation < 8; orientation++) {
+        uint32_t flags = (orientation & 1 ? kFlippedHorizontallyFlag : 0) |
+            (orientation & 2 ? kFlippedVerticallyFlag : 0) |
+            (orientation & 4 ? kFlippedDiagonallyFlag : 0);
+        CHECK(tmj.gids[orientation] == (2 | flags));
+    }
+    
+    // Without matching flips every orientation is a tile of its own.
+    xTiled plain;
+    setUp(plain, tileSize);
+    CHECK(convertMap(plain, path("flips.png"), path("plain")));
+    CHECK(readTMJFile(path("plain.tmj"), tmj));
+    CHECK(tmj.gids == std::vector<uint32_t>({2, 3, 4, 5, 6, 7, 8, 9}));
+    return true;
+}
+
+/*
+ The image view compares give the counts a byte at a time compare would, whichever compare kernel the
+ CPU selected, for every row length and alignment around the vector widths.
+ */
+static bool compareMatchesBytewise(const TImageView& a, const TImageView& b) {
+    size_t size = (size_t)a.width * (a.bitWidth / 8) * a.height;
+    size_t matches = countEqualBytes(a, b);
+    CHECK(compareImageViewMatchCount(a, b) == matches);
+    CHECK(compareImageViews(a, b) == (matches == size));
+    for (float threshold : {0.0f, 0.5f, 0.9f, 0.99f, 1.0f, (float)matches / (float)size}) {
+        CHECK(compareImageViewAtLeast(a, b, threshold) == ((float)matches / (float)size >= threshold));
+    }
+    return true;
+}
+
+static bool compareKernelsMatchBytewiseCompare(void) {
+    for (int bitWidth : {8, 32}) {
+        TImage* a = randomImage(80, 5, bitWidth, 1);
+        TImage* b = copyImage(a);
+        TImage* c = copyImage(a);
+        CHECK(a && b && c);
+        scrambleBytes(b, 7, 2);
+        
+        size_t bytesPerPixel = bitWidth / 8;
+        bool same = true;
+        for (uint32_t x = 0; x < 4 && same; x++) {
+            for (uint32_t width = 1; x + width <= a->width && same; width++) {
+                TImageView viewA = makeImageView(a, x, 1, width, 3);
+                same = compareMatchesBytewise(viewA, makeImageView(b, x, 1, width, 3)) &&
+                    compareMatchesBytewise(viewA, makeImageView(c, x, 1, width, 3));
+                
+                // A single differing byte is found wherever it is, the last byte being in any tail loop.
+                for (size_t i : {(size_t)0, width * bytesPerPixel / 2, width * bytesPerPixel - 1}) {
+                    uint8_t* byte = c->data + ((size_t)3 * c->width + x) * bytesPerPixel + i;
+                    *byte ^= 0x01;
+                    same = same && compareMatchesBytewise(viewA, makeImageView(c, x, 1, width, 3));
+                    *byte ^= 0x01;
+                }
+            }
+        }
+        
+        reset(a);
+        reset(b);
+        reset(c);
+        if (!same) std::cerr << "compare kernel: " << compareKernelName() << std::endl;
+        CHECK(same);
+    }
+    return true;
+}
+
+/*
+ The kernels compiled for the common tile sizes give what the generic kernels give, on tiles within a
+ wider image and on a tile differing in a single byte.
+ */
+static bool tileKernelsMatch(const TTileKernels& kernels, const TTileKernels& generic, const TImageView& a, const TImageView& b) {
+    CHECK(kernels.equal(a, b) == generic.equal(a, b));
+    CHECK(kernels.matchCount(a, b) == generic.matchCount(a, b));
+    for (float threshold : {0.0f, 0.5f, 0.9f, 0.99f, 1.0f}) {
+        CHECK(kernels.atLeast(a, b, threshold) == generic.atLeast(a, b, threshold));
+    }
+    CHECK(kernels.hash(a) == generic.hash(a) && kernels.hash(b) == generic.hash(b));
+    
+    size_t length = (size_t)a.width * (a.bitWidth / 8), stride = length + 3;
+    std::vector<uint8_t> copy(stride * a.height, 0), genericCopy(stride * a.height, 0);
+    kernels.copy(copy.data(), stride, a);
+    generic.copy(genericCopy.data(), stride, a);
+    CHECK(copy == genericCopy);
+    return true;
+}
+
+static bool tileKernelsMatchGenericKernels(void) {
+    const TTileKernels& generic = selectTileKernels(0, 0, 32);
+    CHECK(std::string(generic.name) == "generic");
+    
+    for (int bitWidth : {8, 32}) {
+        for (uint32_t size : {8, 16, 24, 32}) {
+            const TTileKernels& kernels = selectTileKernels(size, size, (uint8_t)bitWidth);
+            CHECK(kernels.width == size && kernels.height == size && kernels.bitWidth == bitWidth);
+            
+            TImage* a = randomImage(size * 2 + 1, size + 1, bitWidth, size);
+            TImage* b = copyImage(a);
+            TImage* c = copyImage(a);
+            CHECK(a && b && c);
+            scrambleBytes(b, 11, size + 1);
+            
+            size_t bytesPerPixel = bitWidth / 8;
+            TImageView tile = makeImageView(a, 1, 1, size, size);
+            bool same = tileKernelsMatch(kernels, generic, tile, makeImageView(b, 1, 1, size, size)) &&
+                tileKernelsMatch(kernels, generic, tile, makeImageView(c, 1, 1, size, size)) &&
+                tileKernelsMatch(kernels, generic, tile, makeImageView(a, size + 1, 0, size, size));
+            for (size_t i : {(size_t)0, (size_t)size * bytesPerPixel - 1}) {
+                uint8_t* byte = c->data + ((size_t)size * c->width + 1) * bytesPerPixel + i;
+                *byte ^= 0x01;
+                same = same && tileKernelsMatch(kernels, generic, tile, makeImageView(c, 1, 1, size, size));
+                *byte ^= 0x01;
+            }
+            
+            reset(a);
+            reset(b);
+            reset(c);
+            CHECK(same);
+        }
+    }
+    return true;
+}
+
+//MARK: - Main
+
+typedef struct {
+    const char *name;
+    bool (*check)(void);
+} TCheck;
+
+static const TCheck checks[] = {
+    {"updateMatchesConversion", updateMatchesConversion},
+    {"updateMatchesConversionWithFullTileset", updateMatchesConversionWithFullTileset},
+    {"updateKeepsSharedTileset", updateKeepsSharedTileset},
+    {"externalTilesetHasRoomToAppend", externalTilesetHasRoomToAppend},
+    {"indexedMapRoundTrips", indexedMapRoundTrips},
+    {"indexedConversionFailsWithTooManyColours", indexedConversionFailsWithTooManyColours},
+    {"largeSparseImageConverts", largeSparseImageConverts},
+    {"layerEncodingsReadBack", layerEncodingsReadBack},
+    {"chunkedMapReassembles", chunkedMapReassembles},
+    {"indexKeepsGIDsAcrossRuns", indexKeepsGIDsAcrossRuns},
+    {"externalTilesetWithMarginAndSpacing", externalTilesetWithMarginAndSpacing},
+    {"flippedTilesGetFlipFlags", flippedTilesGetFlipFlags},
+    {"compareKernelsMatchBytewiseCompare", compareKernelsMatchBytewiseCompare},
+    {"tileKernelsMatchGenericKernels", tileKernelsMatchGenericKernels}
+};
+
+int main(int argc, const char * argv[]) {
+    std::string filter;
+    for (int n = 1; n < argc; n++) {
+        std::string args(argv[n]);
+        if (args == "--filter" && n + 1 < argc) {
+            filter = argv[++n];
+            continue;
+        }
+        std::cerr << "Usage: xtiled_tests [--filter <text>]" << std::endl;
+        return -1;
+    }
+    
+    // xTiled reports every file it saves, only the results of the checks are shown.
+    std::streambuf* output = std::cout.rdbuf(nullptr);
+    
+    int failures = 0;
+    for (const TCheck& check : checks) {
+        if (!filter.empty() && std::string(check.name).find(filter) == std::string::npos)
+            continue;
+        
+        directory = std::filesystem::temp_directory_path() / ("xtiled_tests_" + std::to_string(getpid()));
+        std::filesystem::create_directories(directory);
+        bool passed = check.check();
+        std::filesystem::remove_all(directory);
+        
+        std::cerr << (passed ? "ok      " : "FAILED  ") << check.name << std::endl;
+        if (!passed) failures++;
+    }
+    
+    std::cout.rdbuf(output);
+    std::cout.clear();
+    
+    return failures ? 1 : 0;
+}